@@ -0,0 +1,88 @@
+#ifndef al_layer_h
+#define al_layer_h
+
+#include <cstdio>
+
+#include "al_math.h"
+
+/*
+	A compositor layer: a texture shown on a quad in the HMD, composited (and reprojected) by the
+	driver's compositor rather than drawn into the scene, so that it can update at its own, lower rate.
+
+	vr.layer objects fill in a Layer, and add it to the process-wide Layers registry.
+	The vr object reads the registry whenever it submits a frame, and owns all driver resources
+	(Oculus: an ovrLayerQuad & swap chain per layer; SteamVR: an IVROverlay quad per layer).
+
+	Registry slots are reused; a slot's generation changes whenever its layer is added or removed,
+	so that the vr object knows when to recreate its driver resources for that slot.
+
+	Like PoseChannel, the registry is stored in the s_thing of a private symbol, so that separately
+	loaded externals can share it. All access is from the main thread.
+*/
+
+#define VR_MAX_LAYERS (15) // LibOVR allows 16 layers per frame, one of which is the scene
+
+struct Layer {
+	// what to show:
+	const char * texture = 0;		// name of a jit.gl.texture (a symbol's s_name, so never freed); null to hide
+	uint32_t serial = 0;			// incremented whenever the texture content should be resubmitted
+
+	// where:
+	glm::quat quat;
+	glm::vec3 position;				// of the quad's center, in meters
+	float width = 1.f;				// in meters; the height follows the texture's aspect ratio
+	bool head_locked = false;		// pose relative to the head, rather than in the world (vr's @position/@quat)
+
+	// how often:
+	double rate = 0.;				// resubmissions per second; 0 for every frame
+	bool is_static = false;			// resubmit only when serial changes (a single-buffer StaticImage swap chain)
+};
+
+struct Layers {
+
+	// marker to check that a registry slot really holds a Layers:
+	static const uint32_t MAGIC = 0x76726c79; // "vrly"
+
+	uint32_t magic = MAGIC;
+	Layer * slots[VR_MAX_LAYERS];
+	uint32_t generations[VR_MAX_LAYERS];
+
+	Layers() {
+		for (int i = 0; i < VR_MAX_LAYERS; i++) {
+			slots[i] = 0;
+			generations[i] = 0;
+		}
+	}
+
+	// returns the slot index, or -1 if all slots are in use
+	int add(Layer * layer) {
+		for (int i = 0; i < VR_MAX_LAYERS; i++) {
+			if (!slots[i]) {
+				slots[i] = layer;
+				generations[i]++;
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	void remove(int slot) {
+		if (slot < 0 || slot >= VR_MAX_LAYERS) return;
+		slots[slot] = 0;
+		generations[slot]++;
+	}
+
+	// find or create the registry (pass gensym; see PoseChannel::find)
+	template<typename T>
+	static Layers * find(T * (*symbol_fn)(const char *)) {
+		void ** slot = (void **)&symbol_fn("__vr_layers")->s_thing;
+		Layers * layers = (Layers *)(*slot);
+		if (layers && layers->magic == MAGIC) return layers;
+		if (layers) return 0; // slot is in use by something else
+		layers = new Layers;
+		*slot = layers;
+		return layers;
+	}
+};
+
+#endif /* al_layer_h */
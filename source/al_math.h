@@ -95,6 +95,267 @@ inline glm::tvec3<T, P> quat_uz(glm::tquat<T, P> const & q) {
 		);
 }
 
+/*
+	A rigid transform: rotation (normalized quat) followed by translation.
+
+	Composing tracked poses this way is cheaper than with mat4,
+	and the orientation never needs to be recovered from a matrix (glm::quat_cast).
+	Like mat4, (a * b) applies b first, then a.
+*/
+struct Pose {
+	glm::quat quat;
+	glm::vec3 position;
+
+	Pose() : quat(1.f, 0.f, 0.f, 0.f), position(0.f) {}
+	Pose(glm::quat const & q, glm::vec3 const & p) : quat(q), position(p) {}
+
+	// m must be a rigid transform (no scale or shear)
+	static Pose from_mat4(glm::mat4 const & m) {
+		return Pose(glm::quat_cast(m), glm::vec3(m[3]));
+	}
+
+	glm::mat4 to_mat4() const {
+		return glm::mat4(
+			glm::vec4(quat_ux(quat), 0.f),
+			glm::vec4(quat_uy(quat), 0.f),
+			glm::vec4(quat_uz(quat), 0.f),
+			glm::vec4(position, 1.f));
+	}
+
+	glm::vec3 rotate(glm::vec3 v) const { return quat_rotate(quat, v); }
+	glm::vec3 unrotate(glm::vec3 v) const { return quat_unrotate(quat, v); }
+	glm::vec3 transform(glm::vec3 v) const { return position + quat_rotate(quat, v); }
+
+	Pose inverse() const {
+		glm::vec3 p = -position;
+		return Pose(glm::conjugate(quat), quat_unrotate(quat, p));
+	}
+
+	Pose operator*(Pose const & b) const {
+		return Pose(quat * b.quat, transform(b.position));
+	}
+};
+
+/*
+	Batches of vec3s & poses, stored as structure-of-arrays,
+	for transforming all tracked devices at once.
+
+	Kernels use AVX (8 lanes) or SSE2 (4 lanes) where the compiler targets them,
+	otherwise (or with AL_BATCH_SCALAR defined) plain scalar loops. They take the number of slots in use (n), and process
+	whole groups of lanes up to it, so the slots after n are harmless padding.
+	Batches are not aligned: they may live inside Max-allocated objects, which only
+	get malloc's alignment, so loads & stores are unaligned.
+*/
+
+#define AL_BATCH_SIZE 64
+
+#if defined(AL_BATCH_SCALAR)
+	// no lanes: the scalar loops
+#elif defined(__AVX__)
+	#include <immintrin.h>
+	#define AL_BATCH_LANES 8
+	typedef __m256 al_vf;
+	#define al_vf_load _mm256_loadu_ps
+	#define al_vf_store _mm256_storeu_ps
+	#define al_vf_set1 _mm256_set1_ps
+	#define al_vf_add _mm256_add_ps
+	#define al_vf_sub _mm256_sub_ps
+	#define al_vf_mul _mm256_mul_ps
+	#define al_vf_max _mm256_max_ps
+	#define al_vf_sqrt _mm256_sqrt_ps
+	#define al_vf_div _mm256_div_ps
+	#define al_vf_eq(a, b) _mm256_cmp_ps(a, b, _CMP_EQ_OQ)
+	// where mask is set, b; otherwise a
+	#define al_vf_select(a, b, mask) _mm256_blendv_ps(a, b, mask)
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define AL_BATCH_LANES 4
+	typedef __m128 al_vf;
+	#define al_vf_load _mm_loadu_ps
+	#define al_vf_store _mm_storeu_ps
+	#define al_vf_set1 _mm_set1_ps
+	#define al_vf_add _mm_add_ps
+	#define al_vf_sub _mm_sub_ps
+	#define al_vf_mul _mm_mul_ps
+	#define al_vf_max _mm_max_ps
+	#define al_vf_sqrt _mm_sqrt_ps
+	#define al_vf_div _mm_div_ps
+	#define al_vf_eq _mm_cmpeq_ps
+	#define al_vf_select(a, b, mask) _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a))
+#endif
+
+// the slots a kernel processes for n in use: n rounded up to whole groups of lanes
+inline int al_batch_count(int n) {
+#ifdef AL_BATCH_LANES
+	n = (n + AL_BATCH_LANES - 1) / AL_BATCH_LANES * AL_BATCH_LANES;
+#endif
+	return n < AL_BATCH_SIZE ? n : AL_BATCH_SIZE;
+}
+
+struct Vec3Batch {
+	float x[AL_BATCH_SIZE];
+	float y[AL_BATCH_SIZE];
+	float z[AL_BATCH_SIZE];
+
+	Vec3Batch() {
+		for (int i = 0; i < AL_BATCH_SIZE; i++) x[i] = y[i] = z[i] = 0.f;
+	}
+
+	glm::vec3 get(int i) const { return glm::vec3(x[i], y[i], z[i]); }
+	void set(int i, glm::vec3 const & v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+
+	// gather n float[3]s that are stride bytes apart (e.g. a member of an array of structs)
+	void gather(const void * src, size_t stride, int n) {
+		const char * p = (const char *)src;
+		for (int i = 0; i < n; i++, p += stride) {
+			const float * v = (const float *)p;
+			x[i] = v[0]; y[i] = v[1]; z[i] = v[2];
+		}
+	}
+
+	// v = m * v + t, where m is a 3x3 matrix given by its columns, for the first n vectors
+	void transform(glm::vec3 const & c0, glm::vec3 const & c1, glm::vec3 const & c2, glm::vec3 const & t, int n = AL_BATCH_SIZE) {
+		n = al_batch_count(n);
+#ifdef AL_BATCH_LANES
+		al_vf m00 = al_vf_set1(c0.x), m10 = al_vf_set1(c0.y), m20 = al_vf_set1(c0.z);
+		al_vf m01 = al_vf_set1(c1.x), m11 = al_vf_set1(c1.y), m21 = al_vf_set1(c1.z);
+		al_vf m02 = al_vf_set1(c2.x), m12 = al_vf_set1(c2.y), m22 = al_vf_set1(c2.z);
+		al_vf tx = al_vf_set1(t.x), ty = al_vf_set1(t.y), tz = al_vf_set1(t.z);
+		for (int i = 0; i < n; i += AL_BATCH_LANES) {
+			al_vf vx = al_vf_load(x + i), vy = al_vf_load(y + i), vz = al_vf_load(z + i);
+			al_vf_store(x + i, al_vf_add(tx, al_vf_add(al_vf_mul(m00, vx), al_vf_add(al_vf_mul(m01, vy), al_vf_mul(m02, vz)))));
+			al_vf_store(y + i, al_vf_add(ty, al_vf_add(al_vf_mul(m10, vx), al_vf_add(al_vf_mul(m11, vy), al_vf_mul(m12, vz)))));
+			al_vf_store(z + i, al_vf_add(tz, al_vf_add(al_vf_mul(m20, vx), al_vf_add(al_vf_mul(m21, vy), al_vf_mul(m22, vz)))));
+		}
+#else
+		for (int i = 0; i < n; i++) {
+			glm::vec3 v(x[i], y[i], z[i]);
+			set(i, t + c0 * v.x + c1 * v.y + c2 * v.z);
+		}
+#endif
+	}
+
+	// rotate the first n vectors by a (normalized) quat
+	void rotate(glm::quat const & q, int n = AL_BATCH_SIZE) {
+		transform(quat_ux(q), quat_uy(q), quat_uz(q), glm::vec3(0.f), n);
+	}
+};
+
+struct PoseBatch {
+	Vec3Batch position;
+	float qx[AL_BATCH_SIZE];
+	float qy[AL_BATCH_SIZE];
+	float qz[AL_BATCH_SIZE];
+	float qw[AL_BATCH_SIZE];
+
+	PoseBatch() {
+		for (int i = 0; i < AL_BATCH_SIZE; i++) {
+			qx[i] = qy[i] = qz[i] = 0.f;
+			qw[i] = 1.f;
+		}
+	}
+
+	Pose get(int i) const { return Pose(glm::quat(qw[i], qx[i], qy[i], qz[i]), position.get(i)); }
+	void set(int i, Pose const & p) {
+		qx[i] = p.quat.x; qy[i] = p.quat.y; qz[i] = p.quat.z; qw[i] = p.quat.w;
+		position.set(i, p.position);
+	}
+
+	// pose[i] = a * pose[i], for the first n poses
+	// e.g. to move tracking-space poses into world space
+	void premultiply(Pose const & a, int n = AL_BATCH_SIZE) {
+		position.transform(quat_ux(a.quat), quat_uy(a.quat), quat_uz(a.quat), a.position, n);
+		n = al_batch_count(n);
+#ifdef AL_BATCH_LANES
+		al_vf ax = al_vf_set1(a.quat.x), ay = al_vf_set1(a.quat.y), az = al_vf_set1(a.quat.z), aw = al_vf_set1(a.quat.w);
+		for (int i = 0; i < n; i += AL_BATCH_LANES) {
+			al_vf x = al_vf_load(qx + i), y = al_vf_load(qy + i), z = al_vf_load(qz + i), w = al_vf_load(qw + i);
+			al_vf_store(qw + i, al_vf_sub(al_vf_sub(al_vf_mul(aw, w), al_vf_mul(ax, x)), al_vf_add(al_vf_mul(ay, y), al_vf_mul(az, z))));
+			al_vf_store(qx + i, al_vf_add(al_vf_add(al_vf_mul(aw, x), al_vf_mul(ax, w)), al_vf_sub(al_vf_mul(ay, z), al_vf_mul(az, y))));
+			al_vf_store(qy + i, al_vf_add(al_vf_sub(al_vf_mul(aw, y), al_vf_mul(ax, z)), al_vf_add(al_vf_mul(ay, w), al_vf_mul(az, x))));
+			al_vf_store(qz + i, al_vf_add(al_vf_sub(al_vf_add(al_vf_mul(aw, z), al_vf_mul(ax, y)), al_vf_mul(ay, x)), al_vf_mul(az, w)));
+		}
+#else
+		for (int i = 0; i < n; i++) {
+			glm::quat q = a.quat * glm::quat(qw[i], qx[i], qy[i], qz[i]);
+			qx[i] = q.x; qy[i] = q.y; qz[i] = q.z; qw[i] = q.w;
+		}
+#endif
+	}
+
+	// convert n row-major 3x4 rigid matrices (float[3][4], e.g. OpenVR's HmdMatrix34_t)
+	// that are stride bytes apart in memory
+	// the quat is taken from whichever of w, x, y, z is largest, for accuracy
+	void from_mat34(const void * src, size_t stride, int n) {
+		float m[9][AL_BATCH_SIZE];
+		const char * p = (const char *)src;
+		int count = al_batch_count(n);
+		for (int i = 0; i < count; i++, p += stride) {
+			if (i < n) {
+				const float * r = (const float *)p;
+				m[0][i] = r[0]; m[1][i] = r[1]; m[2][i] = r[2];
+				m[3][i] = r[4]; m[4][i] = r[5]; m[5][i] = r[6];
+				m[6][i] = r[8]; m[7][i] = r[9]; m[8][i] = r[10];
+				position.x[i] = r[3]; position.y[i] = r[7]; position.z[i] = r[11];
+			}
+			else {
+				// identity padding
+				m[0][i] = m[4][i] = m[8][i] = 1.f;
+				m[1][i] = m[2][i] = m[3][i] = m[5][i] = m[6][i] = m[7][i] = 0.f;
+				position.x[i] = position.y[i] = position.z[i] = 0.f;
+			}
+		}
+		// each t is 4 * (component)^2:
+#ifdef AL_BATCH_LANES
+		al_vf one = al_vf_set1(1.f), half = al_vf_set1(0.5f);
+		for (int i = 0; i < count; i += AL_BATCH_LANES) {
+			al_vf m00 = al_vf_load(m[0] + i), m01 = al_vf_load(m[1] + i), m02 = al_vf_load(m[2] + i);
+			al_vf m10 = al_vf_load(m[3] + i), m11 = al_vf_load(m[4] + i), m12 = al_vf_load(m[5] + i);
+			al_vf m20 = al_vf_load(m[6] + i), m21 = al_vf_load(m[7] + i), m22 = al_vf_load(m[8] + i);
+			al_vf tw = al_vf_add(one, al_vf_add(m00, al_vf_add(m11, m22)));
+			al_vf tx = al_vf_add(one, al_vf_sub(m00, al_vf_add(m11, m22)));
+			al_vf ty = al_vf_add(one, al_vf_sub(m11, al_vf_add(m00, m22)));
+			al_vf tz = al_vf_add(one, al_vf_sub(m22, al_vf_add(m00, m11)));
+			al_vf a = al_vf_sub(m21, m12), b = al_vf_sub(m02, m20), c = al_vf_sub(m10, m01);
+			al_vf d = al_vf_add(m01, m10), e = al_vf_add(m02, m20), f = al_vf_add(m12, m21);
+			al_vf tmax = al_vf_max(al_vf_max(tw, tx), al_vf_max(ty, tz));
+			al_vf r = al_vf_div(half, al_vf_sqrt(tmax));
+			// z case, overridden by y, x, then w (highest priority):
+			al_vf w = c, x = e, y = f, z = tz;
+			al_vf mask = al_vf_eq(ty, tmax);
+			w = al_vf_select(w, b, mask); x = al_vf_select(x, d, mask); y = al_vf_select(y, ty, mask); z = al_vf_select(z, f, mask);
+			mask = al_vf_eq(tx, tmax);
+			w = al_vf_select(w, a, mask); x = al_vf_select(x, tx, mask); y = al_vf_select(y, d, mask); z = al_vf_select(z, e, mask);
+			mask = al_vf_eq(tw, tmax);
+			w = al_vf_select(w, tw, mask); x = al_vf_select(x, a, mask); y = al_vf_select(y, b, mask); z = al_vf_select(z, c, mask);
+			al_vf_store(qw + i, al_vf_mul(w, r));
+			al_vf_store(qx + i, al_vf_mul(x, r));
+			al_vf_store(qy + i, al_vf_mul(y, r));
+			al_vf_store(qz + i, al_vf_mul(z, r));
+		}
+#else
+		for (int i = 0; i < count; i++) {
+			float m00 = m[0][i], m01 = m[1][i], m02 = m[2][i];
+			float m10 = m[3][i], m11 = m[4][i], m12 = m[5][i];
+			float m20 = m[6][i], m21 = m[7][i], m22 = m[8][i];
+			float tw = 1.f + m00 + m11 + m22;
+			float tx = 1.f + m00 - m11 - m22;
+			float ty = 1.f - m00 + m11 - m22;
+			float tz = 1.f - m00 - m11 + m22;
+			float a = m21 - m12, b = m02 - m20, c = m10 - m01;
+			float d = m01 + m10, e = m02 + m20, f = m12 + m21;
+			float w, x, y, z, t;
+			if (tw >= tx && tw >= ty && tw >= tz) { t = tw; w = tw; x = a; y = b; z = c; }
+			else if (tx >= ty && tx >= tz) { t = tx; w = a; x = tx; y = d; z = e; }
+			else if (ty >= tz) { t = ty; w = b; x = d; y = ty; z = f; }
+			else { t = tz; w = c; x = e; y = f; z = tz; }
+			float r = 0.5f / sqrtf(t);
+			qw[i] = w * r; qx[i] = x * r; qy[i] = y * r; qz[i] = z * r;
+		}
+#endif
+	}
+};
+
 #endif
 
 
@@ -0,0 +1,83 @@
+#ifndef al_perf_h
+#define al_perf_h
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+/*
+	Per-stage frame timing.
+
+	A PerfStage keeps the durations of its last PERF_WINDOW runs in a ring.
+	Percentiles are only computed (from a sorted copy of the ring) when asked for,
+	so recording a run costs two clock reads and a store.
+
+	Each stage has a single writer. The ring count is atomic, so that another thread may read the stats,
+	which are then approximately current (a sample may be overwritten while it is copied).
+
+	PerfScope times the enclosing block; when constructed with enabled == false it doesn't read the clock at all.
+*/
+
+#define PERF_WINDOW (512)
+
+struct PerfStats {
+	double p50 = 0., p95 = 0., p99 = 0., max = 0., mean = 0.; // ms
+	uint32_t count = 0;	// runs recorded since the last reset (not just those in the window)
+};
+
+struct PerfStage {
+	float samples[PERF_WINDOW];
+	std::atomic<uint32_t> count;
+
+	PerfStage() { reset(); }
+
+	void reset() { count.store(0, std::memory_order_release); }
+
+	void record(double ms) {
+		uint32_t n = count.load(std::memory_order_relaxed);
+		samples[n % PERF_WINDOW] = (float)ms;
+		count.store(n + 1, std::memory_order_release);
+	}
+
+	PerfStats stats() const {
+		PerfStats s;
+		s.count = count.load(std::memory_order_acquire);
+		int n = (int)std::min<uint32_t>(s.count, PERF_WINDOW);
+		if (n == 0) return s;
+		float sorted[PERF_WINDOW];
+		std::copy(samples, samples + n, sorted);
+		std::sort(sorted, sorted + n);
+		double sum = 0.;
+		for (int i = 0; i < n; i++) sum += sorted[i];
+		s.p50 = percentile(sorted, n, 0.50);
+		s.p95 = percentile(sorted, n, 0.95);
+		s.p99 = percentile(sorted, n, 0.99);
+		s.max = sorted[n - 1];
+		s.mean = sum / n;
+		return s;
+	}
+
+	// nearest-rank, of n sorted samples
+	static double percentile(const float * sorted, int n, double p) {
+		int rank = (int)(p * n + 0.999999);
+		return sorted[std::min(std::max(rank, 1), n) - 1];
+	}
+
+	static double now() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+};
+
+struct PerfScope {
+	PerfStage * stage;
+	double t0;
+
+	PerfScope(PerfStage & s, bool enabled) : stage(enabled ? &s : 0), t0(enabled ? PerfStage::now() : 0.) {}
+
+	~PerfScope() {
+		if (stage) stage->record(1000. * (PerfStage::now() - t0));
+	}
+};
+
+#endif /* al_perf_h */
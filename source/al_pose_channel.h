@@ -0,0 +1,156 @@
+#ifndef al_pose_channel_h
+#define al_pose_channel_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+#include "al_math.h"
+
+/*
+	A single pose (orientation + position + timestamp) shared between threads.
+
+	The writer (e.g. the vr object, in the main thread) calls publish().
+	Readers (e.g. audio objects, in perform64) call read() to get a consistent snapshot.
+	It is a seqlock: the writer never blocks, and readers never block the writer;
+	a reader that overlaps a write retries a few times, and otherwise keeps its previous snapshot.
+
+	There should only be one writer per channel at a time.
+
+	Channels are process-wide, so that separately loaded externals can share them.
+	Max's symbol table is used as the registry, e.g.:
+
+		PoseChannel * channel = PoseChannel::find(gensym, "head");
+
+	or, for an attribute setter, PoseChannel::named(gensym, name, (t_object *)x, object_error).
+	find() and named() must be called from the main thread. Channels are never freed.
+
+	An audio object that lets the main thread switch its channel (e.g. with an attribute) should hold the
+	channel in a std::atomic<PoseChannel *>, and keep its snapshot in a PoseFollower, which only the audio thread
+	touches: it notices when the channel has changed, and drops the snapshot taken from the old one.
+*/
+
+struct PoseSnapshot {
+	glm::quat quat;
+	glm::vec3 position;
+	double time = 0.;		// seconds (PoseChannel::now()) when published; 0 if never published
+	uint32_t frame = 0;		// number of times the channel has been published
+};
+
+struct PoseChannel {
+
+	// marker to check that a registry slot really holds a PoseChannel:
+	static const uint32_t MAGIC = 0x76727063; // "vrpc"
+
+	uint32_t magic = MAGIC;
+	std::atomic<uint32_t> seq;	// odd while a write is in progress
+	std::atomic<uint32_t> frame;
+	std::atomic<double> time;
+	std::atomic<float> data[7];	// quat xyzw, position xyz
+
+	PoseChannel() : seq(0), frame(0), time(0.) {
+		for (int i = 0; i < 7; i++) data[i].store(0.f, std::memory_order_relaxed);
+		data[3].store(1.f, std::memory_order_relaxed); // identity quat
+	}
+
+	static double now() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void publish(glm::quat const & q, glm::vec3 const & p, double t = now()) {
+		uint32_t s = seq.load(std::memory_order_relaxed);
+		seq.store(s + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		data[0].store(q.x, std::memory_order_relaxed);
+		data[1].store(q.y, std::memory_order_relaxed);
+		data[2].store(q.z, std::memory_order_relaxed);
+		data[3].store(q.w, std::memory_order_relaxed);
+		data[4].store(p.x, std::memory_order_relaxed);
+		data[5].store(p.y, std::memory_order_relaxed);
+		data[6].store(p.z, std::memory_order_relaxed);
+		time.store(t, std::memory_order_relaxed);
+		frame.store(frame.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+		seq.store(s + 2, std::memory_order_release);
+	}
+
+	// returns true if a consistent snapshot was copied into out
+	// returns false (leaving out untouched) if never published, or if the writer was too busy
+	bool read(PoseSnapshot& out, int retries = 4) const {
+		while (retries-- > 0) {
+			uint32_t s0 = seq.load(std::memory_order_acquire);
+			if (s0 & 1) continue; // write in progress
+
+			PoseSnapshot snap;
+			snap.quat.x = data[0].load(std::memory_order_relaxed);
+			snap.quat.y = data[1].load(std::memory_order_relaxed);
+			snap.quat.z = data[2].load(std::memory_order_relaxed);
+			snap.quat.w = data[3].load(std::memory_order_relaxed);
+			snap.position.x = data[4].load(std::memory_order_relaxed);
+			snap.position.y = data[5].load(std::memory_order_relaxed);
+			snap.position.z = data[6].load(std::memory_order_relaxed);
+			snap.time = time.load(std::memory_order_relaxed);
+			snap.frame = frame.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (seq.load(std::memory_order_relaxed) == s0) {
+				if (snap.frame == 0) return false;
+				out = snap;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// find or create the channel stored in a registry slot (main thread only)
+	static PoseChannel * get(void ** slot) {
+		PoseChannel * channel = (PoseChannel *)(*slot);
+		if (channel && channel->magic == MAGIC) return channel;
+		if (channel) return 0; // slot is in use by something else
+		channel = new PoseChannel;
+		*slot = channel;
+		return channel;
+	}
+
+	// find or create a named channel, stored in the s_thing of a private symbol
+	// (pass gensym; templated so that this header doesn't depend on the Max SDK)
+	template<typename T>
+	static PoseChannel * find(T * (*symbol_fn)(const char *), const char * name) {
+		char buf[256];
+		snprintf(buf, sizeof(buf), "__vr_pose_channel_%s", name);
+		return get((void **)&symbol_fn(buf)->s_thing);
+	}
+
+	// the channel for a @pose_channel value (main thread only): null for no name, or if the name can't be used,
+	// which is reported with error_fn (pass gensym, the object & object_error)
+	// readers may be using the old channel, so store the result into their std::atomic in one go;
+	// each reader's PoseFollower then drops its old snapshot
+	template<typename T, typename O>
+	static PoseChannel * named(T * (*symbol_fn)(const char *), const T * name, O * owner, void (*error_fn)(O *, const char *, ...)) {
+		if (!name || !name->s_name[0]) return 0;
+		PoseChannel * channel = find(symbol_fn, name->s_name);
+		if (!channel) error_fn(owner, "cannot use pose channel %s", name->s_name);
+		return channel;
+	}
+};
+
+// the reading side of a channel that may be switched by another thread
+// (one per reader, in the reader's thread)
+struct PoseFollower {
+	PoseSnapshot pose;
+	const PoseChannel * channel = 0;	// the channel pose was read from
+
+	// read from current (which may be null), forgetting the pose if the channel has changed since the last update
+	// returns whether pose is valid
+	bool update(const PoseChannel * current) {
+		if (current != channel) {
+			channel = current;
+			pose = PoseSnapshot();
+		}
+		if (current) current->read(pose);
+		return pose.frame != 0;
+	}
+};
+
+#endif /* al_pose_channel_h */
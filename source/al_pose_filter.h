@@ -0,0 +1,140 @@
+#ifndef al_pose_filter_h
+#define al_pose_filter_h
+
+#include "al_math.h"
+
+/*
+	Smoothing of a tracked pose, using the device's own velocity estimates.
+
+	ONE_EURO: an adaptive low-pass filter (Casiez et al. 2012).
+		The cutoff rises with speed, so slow movements are smoothed (less jitter)
+		while fast movements pass through (less lag).
+		param[0]: minimum cutoff (Hz), param[1]: beta (cutoff increase in Hz per m/s or rad/s)
+		Since the driver provides velocities, they are used in place of the filter's derivative estimate.
+
+	KALMAN: a constant-velocity Kalman filter per position axis, with position & velocity measured,
+		plus a scalar-variance filter on orientation predicted by the angular velocity
+		(using the same noise parameters, read as radians).
+		param[0]: process noise (acceleration variance, (m/s^2)^2), param[1]: measurement noise (position variance, m^2)
+		The velocity measurement variance is taken as param[1] / dt^2, i.e. as noisy as differenced positions.
+
+	apply() costs a few dozen flops; state is a flat struct so that one per device slot can sit in an array.
+	The filter resets itself after a gap of more than MAX_GAP seconds.
+*/
+
+struct PoseFilter {
+
+	enum Type {
+		NONE = 0,
+		ONE_EURO,
+		KALMAN
+	};
+
+	static constexpr double MAX_GAP = 0.25;
+
+	int type = NONE;
+	float param[2] = { 1.f, 0.5f };
+
+	// state:
+	bool primed = false;
+	double last = 0.;
+	Pose estimate;
+	glm::vec3 velocity;				// KALMAN: estimated velocity
+	glm::vec3 pp, pv, vv;			// KALMAN: per-axis covariance [pp pv; pv vv]
+	float rr = 0.f;					// KALMAN: orientation variance
+
+	void reset() { primed = false; }
+
+	// t is in seconds; vel & angvel are in the same space as the pose
+	Pose apply(Pose const & measured, glm::vec3 const & vel, glm::vec3 const & angvel, double t) {
+		double dt = t - last;
+		last = t;
+		if (type == NONE || !primed || dt <= 0. || dt > MAX_GAP) {
+			primed = true;
+			estimate = measured;
+			velocity = vel;
+			pp = glm::vec3(param[1]);
+			pv = glm::vec3(0.f);
+			vv = glm::vec3(param[1]);
+			rr = param[1];
+			return measured;
+		}
+		switch (type) {
+		case ONE_EURO: one_euro(measured, vel, angvel, float(dt)); break;
+		case KALMAN: kalman(measured, vel, angvel, float(dt)); break;
+		default: estimate = measured; break;
+		}
+		return estimate;
+	}
+
+protected:
+
+	// slerp along the shorter arc
+	static glm::quat blend(glm::quat const & a, glm::quat b, float t) {
+		if (glm::dot(a, b) < 0.f) b = -b;
+		return glm::normalize(glm::slerp(a, b, t));
+	}
+
+	static float lowpass_alpha(float cutoff, float dt) {
+		float tau = 1.f / (6.2831853f * cutoff);
+		return 1.f / (1.f + tau / dt);
+	}
+
+	void one_euro(Pose const & measured, glm::vec3 const & vel, glm::vec3 const & angvel, float dt) {
+		float mincutoff = AL_MAX(param[0], 0.001f);
+		float beta = AL_MAX(param[1], 0.f);
+		float a = lowpass_alpha(mincutoff + beta * glm::length(vel), dt);
+		float ar = lowpass_alpha(mincutoff + beta * glm::length(angvel), dt);
+		estimate.position += a * (measured.position - estimate.position);
+		estimate.quat = blend(estimate.quat, measured.quat, ar);
+	}
+
+	void kalman(Pose const & measured, glm::vec3 const & vel, glm::vec3 const & angvel, float dt) {
+		float q = AL_MAX(param[0], 0.f);
+		float r = AL_MAX(param[1], 1e-12f);
+		float rv = r / (dt * dt);
+		float dt2 = dt * dt, dt3 = dt2 * dt;
+
+		for (int i = 0; i < 3; i++) {
+			// predict:
+			float p = estimate.position[i] + velocity[i] * dt;
+			float v = velocity[i];
+			float Ppp = pp[i] + 2.f * dt * pv[i] + dt2 * vv[i] + q * dt3 / 3.f;
+			float Ppv = pv[i] + dt * vv[i] + q * dt2 / 2.f;
+			float Pvv = vv[i] + q * dt;
+
+			// update with measured position & velocity (H = I, R = diag(r, rv)):
+			float s00 = Ppp + r, s01 = Ppv, s11 = Pvv + rv;
+			float det = s00 * s11 - s01 * s01;
+			if (det <= 0.f) {
+				estimate.position[i] = measured.position[i];
+				velocity[i] = vel[i];
+				continue;
+			}
+			float i00 = s11 / det, i01 = -s01 / det, i11 = s00 / det;
+			// K = P S^-1
+			float k00 = Ppp * i00 + Ppv * i01, k01 = Ppp * i01 + Ppv * i11;
+			float k10 = Ppv * i00 + Pvv * i01, k11 = Ppv * i01 + Pvv * i11;
+			float yp = measured.position[i] - p, yv = vel[i] - v;
+			estimate.position[i] = p + k00 * yp + k01 * yv;
+			velocity[i] = v + k10 * yp + k11 * yv;
+			// P = (I - K) P
+			pp[i] = (1.f - k00) * Ppp - k01 * Ppv;
+			pv[i] = (1.f - k00) * Ppv - k01 * Pvv;
+			vv[i] = -k10 * Ppv + (1.f - k11) * Pvv;
+		}
+
+		// orientation: predict by angular velocity, then blend toward the measurement
+		float angle = glm::length(angvel) * dt;
+		glm::quat predicted = estimate.quat;
+		if (angle > 1e-9f) {
+			predicted = glm::angleAxis(angle, angvel / glm::length(angvel)) * estimate.quat;
+		}
+		rr += q * dt3 / 3.f;
+		float k = rr / (rr + r);
+		rr *= (1.f - k);
+		estimate.quat = blend(predicted, measured.quat, k);
+	}
+};
+
+#endif /* al_pose_filter_h */
@@ -0,0 +1,131 @@
+// vr.layer: show a jit.gl.texture on a quad in the HMD, as a compositor layer
+// the texture is composited (and reprojected) by the driver, at its own rate,
+// rather than drawn into the scene captured for every frame
+// this is cheaper for UI panels, text, video screens etc.
+// the layer is submitted by the vr object in the same process, along with its scene
+
+#include "al_max.h"
+#include "al_layer.h"
+
+static t_class* this_class = nullptr;
+
+struct VrLayer {
+	t_object ob;
+
+	// attrs:
+	glm::vec3 position;
+	glm::quat quat;
+	float width = 1.f;
+	t_atom_long head_locked = 0;
+	double rate = 0.;
+	t_atom_long is_static = 0;
+	t_atom_long enable = 1;
+
+	t_symbol * texture = 0;	// most recent jit_gl_texture
+	Layer layer;
+	Layers * layers = 0;
+	int slot = -1;
+
+	VrLayer() {
+		position = glm::vec3(0.f, 1.f, -1.f);
+		quat = glm::quat(1.f, 0.f, 0.f, 0.f);
+		layers = Layers::find(gensym);
+		if (!layers) {
+			object_error(&ob, "cannot access the layer registry");
+			return;
+		}
+		slot = layers->add(&layer);
+		if (slot < 0) object_error(&ob, "too many layers (at most %d)", VR_MAX_LAYERS);
+		update();
+		// to hear about our own attribute changes (see vr_layer_notify):
+		object_attach_byptr_register(this, this, CLASS_BOX);
+	}
+
+	~VrLayer() {
+		object_detach_byptr(this, this);
+		if (layers && slot >= 0) layers->remove(slot);
+	}
+
+	// copy the attributes into the layer that the vr object reads
+	void update() {
+		layer.position = position;
+		layer.quat = glm::normalize(quat);
+		layer.width = width;
+		layer.head_locked = head_locked != 0;
+		layer.rate = rate;
+		layer.is_static = is_static != 0;
+		layer.texture = (enable && texture) ? texture->s_name : 0;
+	}
+
+	// triggered by "jit_gl_texture" message
+	void jit_gl_texture(t_symbol * name) {
+		texture = name;
+		// (for @static 1, this is what makes the vr object resubmit the content)
+		layer.serial++;
+		update();
+	}
+};
+
+void * vr_layer_new(t_symbol * s, long argc, t_atom * argv) {
+	VrLayer * x = (VrLayer *)object_alloc(this_class);
+	if (x) {
+		x = new (x)VrLayer();
+		attr_args_process(x, (short)argc, argv);
+		x->update();
+	}
+	return x;
+}
+
+void vr_layer_free(VrLayer * x) {
+	x->~VrLayer();
+}
+
+void vr_layer_assist(VrLayer * x, void * b, long m, long a, char * s) {
+	if (m == ASSIST_INLET) {
+		sprintf(s, "texture to show, update to resubmit a static layer");
+	}
+}
+
+void vr_layer_jit_gl_texture(VrLayer * x, t_symbol * s, long argc, t_atom * argv) {
+	if (argc > 0 && atom_gettype(argv) == A_SYM) {
+		x->jit_gl_texture(atom_getsym(argv));
+	}
+}
+
+void vr_layer_update(VrLayer * x) {
+	x->layer.serial++;
+}
+
+// any attribute change is copied into the layer
+t_max_err vr_layer_notify(VrLayer * x, t_symbol * s, t_symbol * msg, void * sender, void * data) {
+	if (msg == gensym("attr_modified")) x->update();
+	return 0;
+}
+
+void ext_main(void * r) {
+	this_class = class_new("vr.layer", (method)vr_layer_new, (method)vr_layer_free, sizeof(VrLayer), 0L, A_GIMME, 0);
+
+	class_addmethod(this_class, (method)vr_layer_assist, "assist", A_CANT, 0);
+	class_addmethod(this_class, (method)vr_layer_jit_gl_texture, "jit_gl_texture", A_GIMME, 0);
+	class_addmethod(this_class, (method)vr_layer_update, "update", 0);
+	class_addmethod(this_class, (method)vr_layer_notify, "notify", A_CANT, 0);
+
+	// pose of the quad's center: in the world (as vr's @position/@quat), or relative to the head with @head_locked
+	CLASS_ATTR_FLOAT_ARRAY(this_class, "position", 0, VrLayer, position, 3);
+	CLASS_ATTR_FLOAT_ARRAY(this_class, "quat", 0, VrLayer, quat, 4);
+	// width in meters (the height follows the texture's aspect ratio)
+	CLASS_ATTR_FLOAT(this_class, "width", 0, VrLayer, width);
+	CLASS_ATTR_FILTER_MIN(this_class, "width", 0.);
+	CLASS_ATTR_ATOM_LONG(this_class, "head_locked", 0, VrLayer, head_locked);
+	CLASS_ATTR_STYLE(this_class, "head_locked", 0, "onoff");
+	// how often (Hz) the texture content is resubmitted; 0 for every frame
+	CLASS_ATTR_DOUBLE(this_class, "rate", 0, VrLayer, rate);
+	CLASS_ATTR_FILTER_MIN(this_class, "rate", 0.);
+	// resubmit only on a new jit_gl_texture or update message, for content that rarely changes
+	CLASS_ATTR_ATOM_LONG(this_class, "static", 0, VrLayer, is_static);
+	CLASS_ATTR_STYLE(this_class, "static", 0, "onoff");
+	CLASS_ATTR_ATOM_LONG(this_class, "enable", 0, VrLayer, enable);
+	CLASS_ATTR_STYLE(this_class, "enable", 0, "onoff");
+
+	class_register(CLASS_BOX, this_class);
+}
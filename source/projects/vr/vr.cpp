@@ -42,6 +42,14 @@ extern "C" {
 #include "openvr.h"
 
 #include "al_math.h"
+#include "al_pose_channel.h"
+#include "al_pose_filter.h"
+#include "al_layer.h"
+#include "al_perf.h"
+#include "vr_session.h"
+#include "vr_submit.h"
+#include "vr_detect.h"
+#include "vr_copy.h"
 
 static bool oculus_initialized = 0;
 
@@ -68,6 +76,27 @@ static t_symbol * ps_buttons;
 
 static t_symbol * ps_oculus;
 static t_symbol * ps_steam;
+static t_symbol * ps_replay;
+static t_symbol * ps_sim;
+static t_symbol * ps_realtime;
+static t_symbol * ps_step;
+static t_symbol * ps_fast;
+static t_symbol * ps_one_euro;
+static t_symbol * ps_kalman;
+
+static t_symbol * ps_messages;
+static t_symbol * ps_matrix;
+static t_symbol * ps_dictionary;
+static t_symbol * ps_sample;
+static t_symbol * ps_record;
+static t_symbol * ps_direct;
+static t_symbol * ps_copy;
+static t_symbol * ps_gl3_copy;
+static t_symbol * ps_mirror;
+static t_symbol * ps_left;
+static t_symbol * ps_right;
+static t_symbol * ps_both;
+static t_symbol * ps_distorted;
 
 glm::quat to_glm(ovrQuatf const q) {
 	return glm::quat(q.w, q.x, q.y, q.z);
@@ -89,6 +118,37 @@ glm::mat4 to_glm(vr::HmdMatrix34_t const m) {
 		m.m[0][3], m.m[1][3], m.m[2][3], 1.0f);
 }
 
+Pose to_pose(ovrPosef const & pose) {
+	return Pose(to_glm(pose.Orientation), to_glm(pose.Position));
+}
+
+// OpenVR only provides matrices, so this is the one place an orientation is decomposed from one
+Pose to_pose(vr::HmdMatrix34_t const & m) {
+	return Pose::from_mat4(to_glm(m));
+}
+
+// and back again, for driver calls that take a pose (compositor layers):
+ovrPosef to_ovr(Pose const & pose) {
+	ovrPosef p;
+	p.Orientation.x = pose.quat.x;
+	p.Orientation.y = pose.quat.y;
+	p.Orientation.z = pose.quat.z;
+	p.Orientation.w = pose.quat.w;
+	p.Position.x = pose.position.x;
+	p.Position.y = pose.position.y;
+	p.Position.z = pose.position.z;
+	return p;
+}
+
+vr::HmdMatrix34_t to_steam(Pose const & pose) {
+	glm::mat4 m = pose.to_mat4();
+	vr::HmdMatrix34_t r;
+	for (int row = 0; row < 3; row++) {
+		for (int col = 0; col < 4; col++) r.m[row][col] = m[col][row];
+	}
+	return r;
+}
+
 glm::mat4 to_glm(vr::HmdMatrix44_t const m) {
 	return glm::mat4(
 		m.m[0][0], m.m[1][0], m.m[2][0], m.m[3][0],
@@ -99,11 +159,206 @@ glm::mat4 to_glm(vr::HmdMatrix44_t const m) {
 
 #include <string>
 #include <fstream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// the maximum number of device rows in the @tracking_format matrix output
+// (one row per device index; oculus uses rows 0..2 for head, left & right hand)
+// this is larger than the bundled OpenVR's k_unMaxTrackedDeviceCount, so that driver sim can fill every slot
+#define VR_MAX_TRACKED_DEVICES (SESSION_MAX_DEVICES)
+
+// SteamVR: the number of textures that scenes are copied into for submission, used in turn
+// so that a texture isn't overwritten while a previous frame may still be using it
+#define STEAM_SUBMIT_TEXTURES (3)
+// the longest to wait for a submit texture to become free (nanoseconds)
+#define STEAM_SUBMIT_WAIT_NS (100000000ull)
+
+// LibOVR has no hidden area mesh, so it is approximated: the visible area is taken as an ellipse per quadrant,
+// reaching this multiple of the FOV tangent in each direction (the corners are at sqrt(2))
+#define OCULUS_VISIBLE_RADIUS (1.25f)
+#define OCULUS_VISIBLE_SEGMENTS (64)
+
+// ovrMirrorOptions, as defined by later LibOVR versions (older runtimes ignore them):
+#define OCULUS_MIRROR_POST_DISTORTION (0x0001)
+#define OCULUS_MIRROR_LEFT_EYE_ONLY (0x0002)
+#define OCULUS_MIRROR_RIGHT_EYE_ONLY (0x0004)
+
+// LibOVR swap chains are typically 3 buffers long
+#define OCULUS_MAX_CHAIN_LENGTH (4)
+
+// SteamVR's "running start": WaitGetPoses returns this long (ms) before the vsync
+#define STEAM_RUNNING_START_MS (3.)
+
+// connect() uses a cached driver detection younger than this (seconds), rather than detecting again
+#define VR_DETECT_MAX_AGE (2.)
+// frames per second to assume when the driver doesn't say (e.g. replay)
+#define VR_DEFAULT_RATE (90.)
+
+// column layout of each device row in the @tracking_format matrix output:
+enum TrackingColumn {
+	TRACKING_CONNECTED = 0,			// 1 if the device was seen this frame
+	TRACKING_TRACKED_POSITION = 1,	// xyz, raw tracking space
+	TRACKING_TRACKED_QUAT = 4,		// xyzw, raw tracking space
+	TRACKING_POSITION = 8,			// xyz, world space
+	TRACKING_QUAT = 11,				// xyzw, world space
+	TRACKING_VELOCITY = 15,			// xyz, world space
+	TRACKING_ANGULAR_VELOCITY = 18,	// xyz, world space
+	TRACKING_TRIGGER = 21,			// touched, value
+	TRACKING_HAND_TRIGGER = 23,		// pressed, value
+	TRACKING_PAD = 25,				// touched, x, y, pressed
+	TRACKING_BUTTONS = 29,			// button 1, button 2
+	TRACKING_COLUMNS = 31
+};
+static_assert(TRACKING_COLUMNS <= SESSION_MAX_COLUMNS, "tracking rows must fit in session rows");
+
+// the stages timed with @perf_timing, each a row of the perf matrix:
+enum PerfStageId {
+	PERF_BANG = 0,		// all of bang()
+	PERF_DRIVER,		// the driver's part of bang() (steam_bang, oculus_bang etc.)
+	PERF_WAIT,			// blocked in WaitGetPoses (or pacing, for driver sim)
+	PERF_OUTPUT,		// sending the device data
+	PERF_TEXTURE,		// all of submitting a jit_gl_texture
+	PERF_COPY,			// copying it into a driver texture
+	PERF_COMMIT,		// committing the swap chain (oculus) or fencing the submit texture (steam)
+	PERF_SUBMIT,		// handing the frame to the compositor
+	PERF_ASYNC,			// with @submit_async: the submit thread waiting for the frame's fence, then handing it to the compositor
+	PERF_STAGES
+};
+static const char * perf_stage_names[PERF_STAGES] = { "bang", "driver", "wait", "output", "texture", "copy", "commit", "submit", "async" };
+// the columns of the perf matrix: p50, p95, p99, max, mean (all ms), count
+// plus a last row of the runtime's own numbers: dropped, reprojected, app_gpu, compositor_gpu, latency (-1 if not known)
+#define PERF_COLUMNS (6)
+// the runtime's own numbers, in that order:
+enum RuntimeStatId {
+	RUNTIME_DROPPED = 0,
+	RUNTIME_REPROJECTED,
+	RUNTIME_APP_GPU,
+	RUNTIME_COMPOSITOR_GPU,
+	RUNTIME_LATENCY,
+	RUNTIME_STATS
+};
+static_assert(RUNTIME_STATS < PERF_COLUMNS, "runtime numbers must fit in a perf matrix row");
+static_assert(vr::k_unMaxTrackedDeviceCount <= VR_MAX_TRACKED_DEVICES, "steam devices must fit in tracking rows");
+static_assert(vr::k_unMaxTrackedDeviceCount <= AL_BATCH_SIZE, "steam devices must fit in pose batches");
+static_assert(sizeof(vr::VREvent_Data_t) <= SESSION_EVENT_DATA, "steam event data must fit in session events");
+static_assert(SESSION_INPUT_AXES + 2 * vr::k_unControllerStateAxisCount <= SESSION_INPUT_WORDS, "steam controller axes must fit in session input");
+// a ring texture is only reused once the submit thread is done with it, so one must always be free:
+static_assert(SUBMIT_QUEUE_DEPTH < STEAM_SUBMIT_TEXTURES, "steam submit ring must outlast the submit queue");
+
+// a frame queued for the submit thread (see @submit_async)
+struct SubmitJob {
+	t_symbol * driver;
+	// steam: the ring texture to submit, and the part of it holding the image
+	GLuint texid;
+	int ring;
+	float umax, vmax;
+	// oculus: the layers to submit, with the frame they were predicted for
+	long long frameIndex;
+	ovrLayerEyeFov eye;
+	ovrLayerQuad quads[VR_MAX_LAYERS];
+	int numquads;
+};
+
+
+// cached properties of an active SteamVR device slot
+struct SteamDevice {
+	vr::ETrackedDeviceClass cls = vr::TrackedDeviceClass_Invalid;
+	vr::ETrackedControllerRole role = vr::TrackedControllerRole_Invalid;
+	t_symbol * serial = 0;
+	t_symbol * id = 0;	// name used for output, e.g. head, left_hand, or the serial of a tracker
+	int live = 0;		// position in the live list + 1, or 0 if not active
+};
+
+// a timestamped device pose sample, in tracking space
+// time is in seconds, on the same clock as PoseChannel::now()
+struct PoseSample {
+	double time;
+	glm::quat quat;
+	glm::vec3 position;
+	glm::vec3 velocity;
+	glm::vec3 angular_velocity;
+};
+
+// single-producer, single-consumer ring of pose samples for one device
+// the producer (the @poll_rate thread) never blocks; 
+// a consumer that falls more than SIZE samples behind loses the oldest ones
+struct PoseRing {
+	static const uint32_t SIZE = 1024; // about a second at 1kHz
+
+	PoseSample samples[SIZE];
+	std::atomic<uint32_t> head; // producer: total number of samples written
+	uint32_t tail = 0;			// consumer: total number of samples read
+
+	PoseRing() : head(0) {}
+
+	void write(PoseSample const & s) {
+		uint32_t h = head.load(std::memory_order_relaxed);
+		samples[h % SIZE] = s;
+		head.store(h + 1, std::memory_order_release);
+	}
+
+	uint32_t written() const { return head.load(std::memory_order_acquire); }
+
+	// the oldest sample number that is still safe to read
+	uint32_t oldest() const {
+		uint32_t h = written();
+		// keep a margin of one slot for a write that may be in progress:
+		return (h > SIZE - 1) ? h - (SIZE - 1) : 0;
+	}
+
+	// copy sample n; returns false if it was overwritten while copying
+	bool read(uint32_t n, PoseSample& out) const {
+		out = samples[n % SIZE];
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return n >= oldest();
+	}
 
+	// find the pose at time t, interpolating between the two nearest samples
+	bool read_at(double t, PoseSample& out) const {
+		uint32_t h = written();
+		if (!h) return false;
+		uint32_t lo = oldest();
+		PoseSample b;
+		if (!read(h - 1, b)) return false;
+		if (t >= b.time) { out = b; return true; }
+		for (uint32_t n = h - 1; n-- > lo; ) {
+			PoseSample a;
+			if (!read(n, a)) return false;
+			if (a.time <= t) {
+				float f = (b.time > a.time) ? float((t - a.time) / (b.time - a.time)) : 0.f;
+				out.time = t;
+				out.quat = glm::slerp(a.quat, b.quat, f);
+				out.position = glm::mix(a.position, b.position, f);
+				out.velocity = glm::mix(a.velocity, b.velocity, f);
+				out.angular_velocity = glm::mix(a.angular_velocity, b.angular_velocity, f);
+				return true;
+			}
+			b = a;
+		}
+		// older than anything we still have:
+		out = b;
+		return true;
+	}
+};
 
 static t_class* this_class = nullptr;
 static bool is_gl3 = false;
 
+struct Vr;
+void vr_schedule_clock(Vr * x);
+void vr_schedule_tick(Vr * x);
+void vr_detect_done(Vr * x);
+void vr_detect(Availability& result);
+
+// shared by all vr objects (see vr_detect.h)
+static AvailabilityDetector * vr_detector() {
+	static AvailabilityDetector * detector = new AvailabilityDetector(vr_detect);
+	return detector;
+}
+
 struct Vr {
 
 	t_object ob;
@@ -122,25 +377,165 @@ struct Vr {
 	float far_clip = 100.f;
 	t_atom_long preferred_driver_only = 0;
 	t_atom_long glfinishhack = 0;
+	t_atom_long submit_waits = 0;	// how often a submit had to wait for a texture to become free
+	double submit_time = 0.;		// smoothed CPU time (ms) of a submit, by the current submit_path
+
+	// @submit_async: the compositor calls are made by a thread with its own GL context, shared with Jitter's,
+	// so that the main thread only fences & queues each frame, rather than blocking in the compositor
+	t_atom_long submit_async = 0;
+	t_atom_long submit_queue = 0;	// frames queued or being submitted, after the last one was queued
+	double submit_wait_time = 0.;	// smoothed ms per frame the submit thread spent waiting (on the GPU & compositor)
+	SubmitWorker<SubmitJob> submit_worker;
+	// SteamVR: held around every compositor & overlay call, since the submit thread's Submit may overlap the main thread's
+	std::mutex compositor_mutex;
+	std::atomic<int> submit_lost;	// set by the submit thread on ovrError_DisplayLost, for the main thread to disconnect
+
+	// @perf_timing: time the stages of each frame (see PerfStageId), for the perf message
+	// and, with @perf_stream, a perf matrix sent every bang()
+	t_atom_long perf_timing = 0;
+	t_atom_long perf_stream = 0;
+	PerfStage perf_stages[PERF_STAGES];
+	void * perf_matrix = 0;
+	// the runtime's own statistics (see runtime_stats_update), shared by @render_adapt, @perf_stream and 'perf'
+	double runtime_stats[RUNTIME_STATS];
+	double runtime_stats_time = -1.;	// bang_time when they were fetched
+	bool runtime_stats_fresh = false;	// whether the runtime had a new frame's timing then
+
+	// @schedule: vr bangs itself once per display frame, as late as it can while still making the next vsync,
+	// then sends 'frame <n>' for the render chain to hang off (instead of a qmetro driving bang)
+	t_atom_long schedule = 0;
+	t_atom_float schedule_margin = 1.;	// ms of slack left before the deadline
+	double schedule_cost = 0.;			// ms from the scheduled time to the end of the frame (rises at once, falls slowly)
+	double schedule_target = 0.;		// PoseChannel::now() the current tick was scheduled for
+	t_atom_long schedule_frames = 0;
+	t_atom_long late_latch = 0;			// with @schedule: latch() just before 'frame'
+	void * schedule_clock = 0;			// fires in the scheduler thread, and sets:
+	void * schedule_qelem = 0;			// which runs the frame in the main thread, where the GL work can happen
 	t_symbol * driver;
 	t_atom_long connected = 0;
 	t_atom_long oculus_available = 0, steam_available = 0;
+	double availability_time = -1.;	// when the availability above was detected (AvailabilityDetector::now())
+	void * detect_qelem = 0;		// set by the detector thread when it has a result
+	bool connect_pending = false;	// connect() is waiting for that result
 	t_atom_long use_camera = 0;
+	t_symbol * tracking_format;
+	t_symbol * submit_path;	// how the last jit_gl_texture reached the driver: none, direct, copy or gl3_copy
+
+	// @mirror: the compositor's own output, as jit.gl.texture wrappers of the driver's textures (no copy)
+	// (re)created in the GL context, on the next jit_gl_texture after @mirror changes
+	t_symbol * mirror;
+	bool mirror_dirty = false;
+	void * mirror_textures[2] = { 0, 0 };	// SteamVR gives one texture per eye
+	t_atom mirror_names[2];
+	int mirror_count = 0;
+
+	// compositor layers of vr.layer objects (see al_layer.h), submitted along with the scene
+	// the driver resources are per registry slot, and recreated whenever the slot's generation changes
+	Layers * layer_registry = 0;
+	struct LayerState {
+		uint32_t generation = 0;
+		uint32_t serial = 0;		// of the content last copied
+		double last = -1.;			// bang_time when the content was last copied
+		bool is_static = false;		// of the content last copied
+		bool visible = false;		// has content, and is shown this frame
+		t_atom_long dim[2] = { 0, 0 };
+		// oculus: a quad layer, with its own swap chain (a single-buffer StaticImage chain for @static 1)
+		ovrTextureSwapChain chain = 0;
+		bool chain_committed = false;	// a layer can't be submitted until its chain has content
+		ovrLayerQuad quad;
+		// steam: an overlay, showing a texture we own
+		vr::VROverlayHandle_t overlay = vr::k_ulOverlayHandleInvalid;
+		GLuint texture = 0;
+	} layer_states[VR_MAX_LAYERS];
+	GLuint layer_fbo_id = 0; // destination of the layer copies (fbo_id may have a depth buffer of the scene's size)
+
+	// device rows captured during bang(), for the tracking matrix and/or the session recorder
+	float tracking_rows[VR_MAX_TRACKED_DEVICES][TRACKING_COLUMNS];
+	bool tracking_capture = false;	// true while rows are being captured this bang()
+	bool tracking_messages = true;	// false if device data is only sent as a matrix this bang()
+
+	// @tracking_format matrix output:
+	// one float32 row per device index, sent once per bang()
+	void * tracking_matrix = 0;
+	t_symbol * tracking_matrix_name = _jit_sym_nothing;
+	long tracking_matrix_stride = 0;
+	// device index -> name dictionary, sent only when the device set changes
+	t_dictionary * tracking_dict = 0;
+	t_symbol * tracking_dict_name = _jit_sym_nothing;
+	t_symbol * tracking_names[VR_MAX_TRACKED_DEVICES];
+	t_symbol * tracking_names_sent[VR_MAX_TRACKED_DEVICES];
 
 	glm::vec3 view_position;
 	glm::quat view_quat;
-	glm::mat4 view_mat; // aka modelview_mat
-	glm::mat4 eye_mat[2]; // pose of each eye, in tracking space
+	Pose view_pose; // tracking space -> world space (from @position & @quat)
+	Pose eye_pose[2]; // pose of each eye, in tracking space
+	Pose head_pose; // pose of the head, in tracking space
+	float eye_frustum[2][6]; // as last sent: left, right, bottom, top, near, far
+
+	// hidden and visible area meshes of both eyes, from configure(), sent as jit.matrix:
+	// float32 3-plane triangle lists, in side-by-side texture coordinates
+	// (x 0..0.5 left eye, 0.5..1 right eye; y as in the submitted texture)
+	enum { AREA_HIDDEN = 0, AREA_VISIBLE };
+	std::vector<glm::vec2> area_mesh[2];
+	void * area_matrix[2] = { 0, 0 };
+
+	// @pose_channel: the world-space head pose is published here each bang()
+	// for audio objects (vr.context~, vr.source~, vr.phonon~) to read in their perform routines
+	t_symbol * pose_channel_name;
+	PoseChannel * pose_channel = 0;
+
+	// @filter: per-device pose smoothing, applied before output
+	// the attributes apply to every device slot, except those set by filter_device
+	// (and except the head, which drives the cameras, unless set by filter_device)
+	t_symbol * filter;
+	float filter_mincutoff = 1.f;			// one_euro
+	float filter_beta = 10.f;				// one_euro
+	float filter_process_noise = 5.f;		// kalman
+	float filter_measurement_noise = 1e-6f;	// kalman
+	PoseFilter filters[VR_MAX_TRACKED_DEVICES];
+	bool filter_custom[VR_MAX_TRACKED_DEVICES];
+	double bang_time = 0.; // PoseChannel::now() at the start of bang()
+
+	// @poll_rate: a background thread samples device poses at this rate (Hz)
+	// into per-device rings, independently of bang() and the render rate
+	t_atom_float poll_rate = 0.;
+	t_systhread poll_thread = 0;
+	std::atomic<int> poll_running;
+	PoseRing * poll_rings = 0; // VR_MAX_TRACKED_DEVICES of them, while polling
+	vr::ETrackingUniverseOrigin poll_origin = vr::TrackingUniverseStanding;
+
+	// record <file>: each bang() is captured into a frame & handed to the recorder,
+	// which encodes it and writes it to disk from its own thread
+	SessionWriter * recorder = 0;
+	SessionFrame * record_frame = 0;
+	double record_start = 0.;
+	// raw controller input captured this bang(), by tracking row (see record_input())
+	uint32_t record_inputs[VR_MAX_TRACKED_DEVICES][SESSION_INPUT_WORDS];
+	bool record_has_input[VR_MAX_TRACKED_DEVICES] = {};
 
 	// guts:
 	
 	// FBO & texture that the scene is copied into
 	// (we can't submit the jit_gl_texture directly)
 	GLuint fbo_id = 0;
+	GLuint fbo_read_id = 0; // source of the blit in fbo_copy_texture
 	GLuint rbo_id = 0;
 	t_atom_long fbo_dim[2];
 	void* gl3_texture = 0;
 
+	// the scene is captured at render_dim = render_scale * fbo_dim, and copied into the corner of the
+	// full-size driver texture, with the texture bounds (steam) or layer viewports (oculus) set to match
+	// so changing the scale never reallocates the driver textures
+	// with @render_adapt, the scale follows the GPU frame time reported by the driver
+	float render_scale = 1.f;
+	float render_scale_min = 0.5f;
+	float render_scale_max = 1.f;
+	float render_headroom = 0.85f;	// the GPU time aimed for, as a fraction of the display's frame period
+	t_atom_long render_adapt = 0;
+	t_atom_long render_dim[2];
+	double render_gpu_ms = 0.;		// smoothed GPU time per frame
+	double render_adapt_last = 0.;	// bang_time when render_scale was last adapted
+
 	// driver-specific:
 	struct {
 		ovrSession session = 0;
@@ -152,7 +547,13 @@ struct Vr {
 		ovrLayerEyeFov layer;
 		//ovrSizei pTextureDim;
 		ovrTextureSwapChain textureChain = 0;
-		ovrMirrorTexture mirrorTexture;
+		// one jit.gl.texture per swap chain buffer, wrapping its glid, so that a capturing
+		// jit.gl.node can render straight into the chain (see oculus_output_chain_texture)
+		void * chainTextures[OCULUS_MAX_CHAIN_LENGTH];
+		t_symbol * chainNames[OCULUS_MAX_CHAIN_LENGTH];
+		GLuint chainIds[OCULUS_MAX_CHAIN_LENGTH];
+		int chainLength = 0;
+		ovrMirrorTexture mirrorTexture = 0;
 		long long frameIndex = 0;
 		double sensorSampleTime = 0.f;    // sensorSampleTime is fed into the layer later
 		int max_fov = 0; // use default field of view; set to 1 for maximum field of view
@@ -164,11 +565,32 @@ struct Vr {
 		vr::IVRSystem *	hmd;
 		t_symbol * driver;
 		t_symbol * display;
-		GLuint fbo_texture_id = 0;
+		GLuint fbo_texture_id = 0;	// the texture being submitted this frame
+		float refresh_rate = 90.f;
+		vr::glUInt_t mirror_ids[2] = { 0, 0 };
+		vr::glSharedTextureHandle_t mirror_handles[2] = { 0, 0 };
+
+		// the ring of submit textures, each with a fence set after its last submission
+		GLuint submit_textures[STEAM_SUBMIT_TEXTURES] = {};
+		GLsync submit_fences[STEAM_SUBMIT_TEXTURES] = {};
+		uint32_t submit_frames[STEAM_SUBMIT_TEXTURES] = {};	// when each was last submitted
+		std::atomic<int> submit_pending[STEAM_SUBMIT_TEXTURES];	// queued for the submit thread, which sets the fence
+		uint32_t submit_frame = 0;
+		int submit_current = -1;	// the ring index of fbo_texture_id, if it is from the ring
 
 		vr::TrackedDevicePose_t pRenderPoseArray[vr::k_unMaxTrackedDeviceCount];
+		// pRenderPoseArray converted in one pass each frame, in tracking & world space:
+		PoseBatch poses, world_poses;
+		Vec3Batch world_velocities, world_angular_velocities;
 		int mHandControllerDeviceIndex[2];
-		glm::mat4 head2eye_mat[2];
+
+		// registry of active devices, so that the per-frame loop doesn't need to
+		// query class/role/serial of every slot; built in steam_connect() and 
+		// updated only by device activated/deactivated/role/updated events
+		SteamDevice devices[vr::k_unMaxTrackedDeviceCount];
+		vr::TrackedDeviceIndex_t live[vr::k_unMaxTrackedDeviceCount]; // compact list of active device indices
+		int numlive = 0;
+		Pose head2eye[2];
 		glm::mat4 m_mat4projectionEye[2];
 
 		vr::IVRRenderModels * mRenderModels = 0;
@@ -249,6 +671,34 @@ struct Vr {
 		} camtex;
 
 	} steam;
+
+	// driver replay: plays back a session file made with record <file>
+	struct {
+		SessionReader reader;
+		SessionFrame frame;				// the most recently decoded frame
+		SessionEvent events[SESSION_MAX_EVENTS]; // events of all frames decoded since the last bang()
+		int numevents = 0;
+		uint32_t frames = 0;			// frames decoded since connect/rewind
+		double start = 0.;				// PoseChannel::now() at which playback time was 0
+		bool ended = false;
+	} replay;
+	t_symbol * replay_file;
+	t_symbol * replay_mode;
+	t_atom_long replay_loop = 0;
+
+	// driver sim: procedural devices, for testing & benchmarking without hardware
+	struct {
+		t_symbol * ids[VR_MAX_TRACKED_DEVICES];
+		bool live[VR_MAX_TRACKED_DEVICES];
+		double start = 0.;			// PoseChannel::now() at connect
+		double last = 0.;			// seconds since start, at the previous bang()
+		double event_accum = 0.;	// fractional attach/detach events carried over
+		uint32_t rng = 1;
+		std::chrono::steady_clock::time_point next_frame;
+	} sim;
+	t_atom_long sim_devices = 3;	// head, hands, then trackers
+	t_atom_float sim_rate = 90.;	// bang() waits for the next frame at this rate (like WaitGetPoses); 0 to not wait
+	t_atom_float sim_events = 0.;	// tracker attach/detach events per second
 	
 	Vr(t_symbol * drawto) {
 		// init Max object:
@@ -263,23 +713,45 @@ struct Vr {
 		outlet_node = outlet_new(&ob, NULL);
 
 		driver = gensym("oculus");
+		tracking_format = ps_messages;
+		replay_file = _jit_sym_nothing;
+		filter = gensym("none");
+		replay_mode = ps_realtime;
+		submit_path = gensym("none");
+		mirror = gensym("none");
+		pose_channel_name = _jit_sym_nothing;
+		layer_registry = Layers::find(gensym);
+		poll_running = 0;
+		submit_lost = 0;
+		for (int i = 0; i < STEAM_SUBMIT_TEXTURES; i++) steam.submit_pending[i] = 0;
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+			tracking_names[i] = 0;
+			tracking_names_sent[i] = 0;
+			filter_custom[i] = false;
+		}
 		
 		// some whatever defaults, will get overwritten when driver connects
 		fbo_dim[0] = 1920;
 		fbo_dim[1] = 1080;
+		render_dim[0] = fbo_dim[0];
+		render_dim[1] = fbo_dim[1];
 
 		// default eye positions (for offline testing)
+		head_pose = Pose(glm::quat(), glm::vec3(0.f, 1.59f, 0.f));
 		for (int eye = 0; eye < 2; eye++) {
 			float ipd = 0.61; // an average adult
 			float eye_height = 1.59;
 			float eye_forward = 0.095; // a typical distance from center of head to eye plane
 			glm::vec3 p(eye ? ipd / 2.f : -ipd / 2.f, eye_height, -eye_forward);
-			eye_mat[eye] = glm::translate(glm::mat4(1.0f), p);
+			eye_pose[eye] = Pose(glm::quat(), p);
+			for (int i = 0; i < 6; i++) eye_frustum[eye][i] = 0.f;
 
 			steam.mHandControllerDeviceIndex[eye] = -1;
 		}
 		steam.camtex.init();
 
+		detect_qelem = qelem_new(this, (method)vr_detect_done);
+		vr_detector()->subscribe(detect_qelem);
 		update_availability();
 	}
 
@@ -288,6 +760,23 @@ struct Vr {
 		dest_closing();
 		// disconnect from session
 		disconnect();
+		// stop hearing from the detector
+		vr_detector()->unsubscribe(detect_qelem);
+		qelem_free(detect_qelem);
+		// stop scheduling
+		if (schedule_clock) clock_free(schedule_clock);
+		if (schedule_qelem) qelem_free(schedule_qelem);
+		// free tracking matrix & dictionary
+		tracking_matrix_free();
+		area_free();
+		if (perf_matrix) jit_object_free(perf_matrix);
+		// stop polling
+		poll_stop();
+		delete[] poll_rings;
+		// finish any recording
+		record_stop();
+		delete recorder;
+		delete record_frame;
 		// remove from jit.gl* hierarchy
 		jit_ob3d_free(this);
 		// actually delete object
@@ -338,29 +827,63 @@ struct Vr {
 		return JIT_ERR_NONE;
 	}
 
+	// detection can block, so happens in the detector thread; detect_done() picks up the result
+	// a recent enough result is used as it is
 	void update_availability() {
-#ifdef USE_OCULUS_DRIVER
-		oculus_available = oculus_is_available();
-		object_attr_touch(&ob, gensym("oculus_available"));
-#endif 
-#ifdef USE_STEAM_DRIVER
-		steam_available = steam_is_available();
-		object_attr_touch(&ob, gensym("steam_available"));
-#endif
-		t_atom a[1];
+		double age = vr_detector()->age();
+		if (age >= 0. && age < VR_DETECT_MAX_AGE) {
+			qelem_set(detect_qelem);
+		}
+		else {
+			vr_detector()->request();
+		}
+	}
 
-		atom_setlong(a, oculus_available);
-		outlet_anything(outlet_msg, gensym("oculus_available"), 1, a);
-		atom_setlong(a, steam_available);
-		outlet_anything(outlet_msg, gensym("steam_available"), 1, a);
+	// in the main thread, once the detector has a result:
+	// output the availability if it has changed, and finish any pending connect()
+	void detect_done() {
+		Availability result = vr_detector()->latest();
+		if (result.time != availability_time) {
+			bool changed = availability_time < 0.
+				|| result.oculus != (oculus_available != 0)
+				|| result.steam != (steam_available != 0);
+			availability_time = result.time;
+			if (changed) {
+				oculus_available = result.oculus;
+				steam_available = result.steam;
+				object_attr_touch(&ob, gensym("oculus_available"));
+				object_attr_touch(&ob, gensym("steam_available"));
+
+				t_atom a[1];
+				atom_setlong(a, oculus_available);
+				outlet_anything(outlet_msg, gensym("oculus_available"), 1, a);
+				atom_setlong(a, steam_available);
+				outlet_anything(outlet_msg, gensym("steam_available"), 1, a);
+			}
+		}
+		if (connect_pending) {
+			connect_pending = false;
+			// this runs from the qelem, outside of Jitter's GL context,
+			// so the GPU resources are left to the next jit_gl_texture (see submit_texture)
+			connect_now(false);
+		}
 	}
 
 	// attempt to acquire the HMD
+	// this completes once the drivers' availability is known (see update_availability), 
+	// with 'connected 1' (or 0) from the outlet; replay & sim don't need a driver, so connect at once
 	bool connect() {
 		if (connected) return true; // because we're already connected!
-		VR_DEBUG_POST("connect");
-
+		if (driver == ps_replay || driver == ps_sim) return connect_now();
+		connect_pending = true;
 		update_availability();
+		return false;
+	}
+
+	// in_context: whether the drawto GL context is current, so that the GPU resources can be made now
+	bool connect_now(bool in_context = true) {
+		if (connected) return true;
+		VR_DEBUG_POST("connect");
 
 		#ifdef USE_STEAM_DRIVER
 		// figure out which driver we want to use:
@@ -373,6 +896,12 @@ struct Vr {
 			#endif
 		}
 		#endif
+		if (driver == ps_replay) {
+			connected = replay_connect();
+		}
+		if (driver == ps_sim) {
+			connected = sim_connect();
+		}
 		#ifdef USE_OCULUS_DRIVER
 		if (driver == ps_oculus) {
 			connected = oculus_connect();
@@ -405,17 +934,29 @@ struct Vr {
 		outlet_anything(outlet_msg, _jit_sym_dim, 2, a);
 
 		// if connected and gpu is ready, go ahead & make what we need
-		if (connected && dest_ready) {
+		// (otherwise submit_texture makes them, when it first finds them missing)
+		if (connected && dest_ready && in_context) {
 			create_gpu_resources();
 		}
+		if (connected) {
+			for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) filters[i].reset();
+			poll_start();
+			schedule_next();
+		}
 		return connected;
 	}
 	
 	// release the HMD
 	void disconnect() {
+		connect_pending = false;
 		if (!connected) return;
 		VR_DEBUG_POST("disconnect");
 
+		// the poll & submit threads use the driver session, so must stop first
+		poll_stop();
+		submit_async_stop();
+		schedule_stop();
+
 		// TODO: driver-specific stuff
 		#ifdef USE_STEAM_DRIVER
 		if (driver == ps_steam) {
@@ -427,6 +968,9 @@ struct Vr {
 			oculus_disconnect();
 		}
 		#endif
+		if (driver == ps_replay) {
+			replay_disconnect();
+		}
 		
 		connected = 0;
 		object_attr_touch(&ob, gensym("connected"));
@@ -452,9 +996,12 @@ struct Vr {
 #endif
 		}
 
-		// output recommended texture dim:
-		atom_setlong(a + 0, fbo_dim[0]);
-		atom_setlong(a + 1, fbo_dim[1]);
+		area_update();
+
+		// output the texture dim to capture at:
+		render_scale_update(true);
+		atom_setlong(a + 0, render_dim[0]);
+		atom_setlong(a + 1, render_dim[1]);
 		outlet_anything(outlet_node, _jit_sym_dim, 2, a);
 		atom_setlong(a, 0);
 		outlet_anything(outlet_node, _jit_sym_adapt, 1, a);
@@ -475,6 +1022,297 @@ struct Vr {
 			
 	}
 	
+	// recompute render_dim from render_scale; if it changed, tell the capture node
+	// (unless force, the caller will send it)
+	void render_scale_update(bool force = false) {
+		render_scale = AL_MIN(AL_MAX(render_scale, AL_MAX(render_scale_min, 0.1f)), AL_MAX(render_scale_max, render_scale_min));
+		float scale = render_scale_applies() ? render_scale : 1.f;
+		// even widths, so that the two eyes get the same number of pixels
+		t_atom_long w = AL_MAX(2, 2 * (t_atom_long)(fbo_dim[0] * scale * 0.5f + 0.5f));
+		t_atom_long h = AL_MAX(1, (t_atom_long)(fbo_dim[1] * scale + 0.5f));
+		if (!force && w == render_dim[0] && h == render_dim[1]) return;
+		render_dim[0] = w;
+		render_dim[1] = h;
+		
+		t_atom a[3];
+		atom_setfloat(a + 0, render_scale);
+		atom_setlong(a + 1, w);
+		atom_setlong(a + 2, h);
+		outlet_anything(outlet_msg, gensym("render_scale"), 3, a);
+		if (!force) outlet_anything(outlet_node, _jit_sym_dim, 2, a + 1);
+	}
+
+	// a frame rendered straight into the Oculus swap chain fills the whole buffer, and is submitted with fbo_dim viewports
+	// (see oculus_submit_texture), so the capture stays at full size while the submit path is direct
+	bool render_scale_applies() {
+		return !(driver == ps_oculus && submit_path == ps_direct);
+	}
+
+	// the display's frame period, in ms
+	bool render_frame_period(float& period_ms) {
+#ifdef USE_STEAM_DRIVER
+		if (driver == ps_steam) {
+			if (!steam.hmd || steam.refresh_rate <= 0.f) return false;
+			period_ms = 1000.f / steam.refresh_rate;
+			return true;
+		}
+#endif
+#ifdef USE_OCULUS_DRIVER
+		if (driver == ps_oculus) {
+			if (!oculus.session || oculus.hmd.DisplayRefreshRate <= 0.f) return false;
+			period_ms = 1000.f / oculus.hmd.DisplayRefreshRate;
+			return true;
+		}
+#endif
+		return false;
+	}
+
+	// called once per bang() with @render_adapt on
+	// (after runtime_stats_update)
+	void render_scale_adapt() {
+		float period_ms;
+		if (!render_scale_applies() || !runtime_stats_fresh || !render_frame_period(period_ms)) return;
+		double gpu_ms = runtime_stats[RUNTIME_APP_GPU];
+		if (gpu_ms <= 0.) return;
+		if (render_gpu_ms <= 0.) render_gpu_ms = gpu_ms;
+		render_gpu_ms += 0.1 * (gpu_ms - render_gpu_ms);
+
+		// give each change time to show up in the timing:
+		if (bang_time - render_adapt_last < 0.5) return;
+
+		// GPU time goes roughly with the number of pixels, i.e. the square of the scale
+		double ratio = render_headroom * period_ms / render_gpu_ms;
+		if (ratio > 0.9 && ratio < 1.2) return; // close enough; don't oscillate
+		// drop quickly when over budget, recover slowly:
+		double scale = render_scale * AL_MIN(AL_MAX(sqrt(ratio), 0.8), 1.05);
+		// in steps of 1/64, so that small timing changes don't resize the capture
+		scale = floor(scale * 64. + 0.5) / 64.;
+		if (scale == render_scale) return;
+		render_scale = (float)scale;
+		render_scale_update();
+		render_adapt_last = bang_time;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////
+
+	// fetch the runtime's own frame statistics into runtime_stats; -1 for those the driver doesn't provide
+	// dropped & reprojected are counts since connecting; the rest are ms for the most recent frame
+	// at most once per bang(), as ovr_GetPerfStats hands out each frame's stats only once
+	void runtime_stats_update() {
+		if (runtime_stats_time == bang_time) return;
+		runtime_stats_time = bang_time;
+		runtime_stats_fresh = false;
+		for (int i = 0; i < RUNTIME_STATS; i++) runtime_stats[i] = -1.;
+		if (!connected) return;
+#ifdef USE_STEAM_DRIVER
+		if (driver == ps_steam && steam.hmd && vr::VRCompositor()) {
+			std::lock_guard<std::mutex> lock(compositor_mutex);
+			vr::Compositor_CumulativeStats stats;
+			vr::VRCompositor()->GetCumulativeStats(&stats, sizeof(stats));
+			runtime_stats[RUNTIME_DROPPED] = stats.m_nNumDroppedFrames;
+			runtime_stats[RUNTIME_REPROJECTED] = stats.m_nNumReprojectedFrames;
+			vr::Compositor_FrameTiming timing;
+			timing.m_nSize = sizeof(timing);
+			if (vr::VRCompositor()->GetFrameTiming(&timing, 0)) {
+				runtime_stats[RUNTIME_APP_GPU] = timing.m_flPreSubmitGpuMs;
+				runtime_stats[RUNTIME_COMPOSITOR_GPU] = timing.m_flCompositorRenderGpuMs;
+				runtime_stats_fresh = true;
+			}
+		}
+#endif
+#ifdef USE_OCULUS_DRIVER
+		if (driver == ps_oculus && oculus.session) {
+			ovrPerfStats stats;
+			if (OVR_SUCCESS(ovr_GetPerfStats(oculus.session, &stats)) && stats.FrameStatsCount > 0) {
+				const ovrPerfStatsPerCompositorFrame& frame = stats.FrameStats[0];
+				runtime_stats[RUNTIME_DROPPED] = frame.AppDroppedFrameCount;
+				runtime_stats[RUNTIME_APP_GPU] = frame.AppGpuElapsedTime * 1000.;
+				runtime_stats[RUNTIME_COMPOSITOR_GPU] = frame.CompositorGpuElapsedTime * 1000.;
+				runtime_stats[RUNTIME_LATENCY] = frame.AppMotionToPhotonLatency * 1000.;
+				runtime_stats_fresh = true;
+			}
+		}
+#endif
+	}
+
+	// perf message: one 'perf <stage> <p50> <p95> <p99> <max> <mean> <count>' per stage (times in ms),
+	// then 'perf <name> <value>' for each of the runtime's numbers that is known
+	// 'perf reset' clears the stages
+	void perf_message(t_symbol * arg) {
+		if (arg == gensym("reset")) {
+			for (int i = 0; i < PERF_STAGES; i++) perf_stages[i].reset();
+			return;
+		}
+		if (!perf_timing) object_warn(&ob, "@perf_timing is off; no stages are being timed");
+		t_atom a[PERF_COLUMNS + 1];
+		for (int i = 0; i < PERF_STAGES; i++) {
+			PerfStats stats = perf_stages[i].stats();
+			atom_setsym(a + 0, gensym(perf_stage_names[i]));
+			atom_setfloat(a + 1, stats.p50);
+			atom_setfloat(a + 2, stats.p95);
+			atom_setfloat(a + 3, stats.p99);
+			atom_setfloat(a + 4, stats.max);
+			atom_setfloat(a + 5, stats.mean);
+			atom_setlong(a + 6, stats.count);
+			outlet_anything(outlet_msg, gensym("perf"), PERF_COLUMNS + 1, a);
+		}
+		static const char * runtime_names[RUNTIME_STATS] = { "dropped", "reprojected", "app_gpu", "compositor_gpu", "latency" };
+		// (those of the latest bang, if any)
+		runtime_stats_update();
+		for (int i = 0; i < RUNTIME_STATS; i++) {
+			if (runtime_stats[i] < 0.) continue;
+			atom_setsym(a + 0, gensym(runtime_names[i]));
+			if (i <= RUNTIME_REPROJECTED) atom_setlong(a + 1, (t_atom_long)runtime_stats[i]);
+			else atom_setfloat(a + 1, runtime_stats[i]);
+			outlet_anything(outlet_msg, gensym("perf"), 2, a);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////
+
+	// ms until the moment bang() should run for the next frame, and the display's frame period; false if unknown
+	// (schedule_margin is taken off later)
+	bool schedule_deadline(double& until_ms, double& period_ms) {
+#ifdef USE_STEAM_DRIVER
+		if (driver == ps_steam) {
+			if (!steam.hmd || steam.refresh_rate <= 0.f) return false;
+			float since = 0.f;
+			uint64_t count = 0;
+			if (!steam.hmd->GetTimeSinceLastVsync(&since, &count)) return false;
+			period_ms = 1000. / steam.refresh_rate;
+			// WaitGetPoses won't return before the running start anyway, and its poses are predicted for the
+			// vsync after, so arriving just before it wastes no time blocked & makes the pose no older:
+			until_ms = period_ms - 1000. * since - STEAM_RUNNING_START_MS;
+			return true;
+		}
+#endif
+#ifdef USE_OCULUS_DRIVER
+		if (driver == ps_oculus) {
+			if (!oculus.session || oculus.hmd.DisplayRefreshRate <= 0.f) return false;
+			period_ms = 1000. / oculus.hmd.DisplayRefreshRate;
+			// the predicted display times are on the vsync grid:
+			double ahead = 1000. * (ovr_GetPredictedDisplayTime(oculus.session, oculus.frameIndex) - ovr_GetTimeInSeconds());
+			until_ms = fmod(ahead, period_ms);
+			if (until_ms < 0.) until_ms += period_ms;
+			// nothing blocks until the pose is due, so the frame must start its own cost ahead of the vsync:
+			until_ms -= schedule_cost;
+			return true;
+		}
+#endif
+		if (driver == ps_sim) {
+			if (sim_rate <= 0.) return false;
+			period_ms = 1000. / sim_rate;
+			// sim_bang() paces like WaitGetPoses, to sim.next_frame + period:
+			until_ms = period_ms + 1000. * std::chrono::duration<double>(sim.next_frame - std::chrono::steady_clock::now()).count();
+			return true;
+		}
+		return false;
+	}
+
+	// the active driver's frames per second, as far as it is known
+	double display_rate() {
+		double rate = 0.;
+#ifdef USE_STEAM_DRIVER
+		if (driver == ps_steam) rate = steam.refresh_rate;
+#endif
+#ifdef USE_OCULUS_DRIVER
+		if (driver == ps_oculus) rate = oculus.hmd.DisplayRefreshRate;
+#endif
+		if (driver == ps_sim) rate = sim_rate;
+		return rate > 0. ? rate : VR_DEFAULT_RATE;
+	}
+
+	void schedule_next() {
+		if (!schedule || !connected) return;
+		if (!schedule_clock) {
+			schedule_clock = clock_new(this, (method)vr_schedule_clock);
+			schedule_qelem = qelem_new(this, (method)vr_schedule_tick);
+		}
+		double until_ms, period_ms;
+		if (!schedule_deadline(until_ms, period_ms) || period_ms <= 0.) {
+			// the driver can't tell: just run at its rate
+			period_ms = 1000. / display_rate();
+			until_ms = period_ms;
+		}
+		double delay = until_ms - schedule_margin;
+		while (delay < 0.) delay += period_ms;
+		// a frame that ended just before its own deadline mustn't be run again for the same vsync:
+		double now = PoseChannel::now();
+		if (schedule_target > 0. && 1000. * (now - schedule_target) + delay < 0.5 * period_ms) delay += period_ms;
+		schedule_target = now + delay / 1000.;
+		clock_fdelay(schedule_clock, delay);
+	}
+
+	void schedule_stop() {
+		if (schedule_clock) clock_unset(schedule_clock);
+		if (schedule_qelem) qelem_unset(schedule_qelem);
+		schedule_target = 0.;
+	}
+
+	// in the main thread, once per frame, with @schedule on
+	void schedule_tick() {
+		if (!schedule || !connected) return;
+		bang();
+		if (late_latch) latch();
+		t_atom a[1];
+		atom_setlong(a, ++schedule_frames);
+		outlet_anything(outlet_msg, gensym("frame"), 1, a);
+
+		// the render chain has normally drawn & submitted by now:
+		double cost = AL_MIN(1000. * (PoseChannel::now() - schedule_target), 100.);
+		if (cost > schedule_cost) schedule_cost = cost;
+		else schedule_cost += 0.05 * (cost - schedule_cost);
+		schedule_next();
+	}
+
+	// @perf_stream: 'perf jit_matrix <name>', a float32 PERF_COLUMNS x (PERF_STAGES + 1) matrix (see PerfStageId)
+	void perf_stream_output() {
+		t_jit_matrix_info info;
+		jit_matrix_info_default(&info);
+		info.type = _jit_sym_float32;
+		info.planecount = 1;
+		info.dimcount = 2;
+		info.dim[0] = PERF_COLUMNS;
+		info.dim[1] = PERF_STAGES + 1;
+		if (!perf_matrix) {
+			perf_matrix = jit_object_new(_jit_sym_jit_matrix, &info);
+			if (!perf_matrix) {
+				object_error(&ob, "failed to create perf matrix");
+				perf_stream = 0;
+				return;
+			}
+			perf_matrix = jit_object_register(perf_matrix, jit_symbol_unique());
+		}
+		jit_object_method(perf_matrix, _jit_sym_getinfo, &info);
+
+		char * data = 0;
+		long savelock = (long)jit_object_method(perf_matrix, _jit_sym_lock, 1);
+		jit_object_method(perf_matrix, _jit_sym_getdata, &data);
+		if (data) {
+			for (int i = 0; i < PERF_STAGES; i++) {
+				PerfStats stats = perf_stages[i].stats();
+				float * row = (float *)(data + i * info.dimstride[1]);
+				row[0] = (float)stats.p50;
+				row[1] = (float)stats.p95;
+				row[2] = (float)stats.p99;
+				row[3] = (float)stats.max;
+				row[4] = (float)stats.mean;
+				row[5] = (float)stats.count;
+			}
+			runtime_stats_update();
+			float * row = (float *)(data + PERF_STAGES * info.dimstride[1]);
+			for (int i = 0; i < RUNTIME_STATS; i++) row[i] = (float)runtime_stats[i];
+			row[5] = 0.f;
+		}
+		jit_object_method(perf_matrix, _jit_sym_lock, savelock);
+		if (!data) return;
+
+		t_atom a[2];
+		atom_setsym(a + 0, _jit_sym_jit_matrix);
+		atom_setsym(a + 1, jit_attr_getsym(perf_matrix, _jit_sym_name));
+		outlet_anything(outlet_msg, gensym("perf"), 2, a);
+	}
+
 	void haptic(int hand, float intensity) {
 #ifdef USE_STEAM_DRIVER
 		if (driver == ps_steam) {
@@ -544,6 +1382,7 @@ struct Vr {
 		// create the FBO used to pass the scene texture to the driver:
 		if (!fbo_id) {
 			glGenFramebuffersEXT(1, &fbo_id);
+			glGenFramebuffersEXT(1, &fbo_read_id);
 		}
 
 #ifdef USE_STEAM_DRIVER
@@ -559,12 +1398,19 @@ struct Vr {
 	}
 
 	void release_gpu_resources() {
+		// (the submit thread's context shares these resources)
+		submit_async_stop();
+		layers_release();
+		mirror_release();
+		mirror_dirty = true; // recreate on the next submit, if still wanted
 		
 		// release associated resources:
 		if (fbo_id) {
 			VR_DEBUG_POST("release_gpu_resources");
 			glDeleteFramebuffersEXT(1, &fbo_id);
+			glDeleteFramebuffersEXT(1, &fbo_read_id);
 			fbo_id = 0;
+			fbo_read_id = 0;
 
 			// TODO driver specific
 #ifdef USE_STEAM_DRIVER
@@ -585,17 +1431,27 @@ struct Vr {
 	// this should be the *last* thing to happen before rendering the scene
 	// nothing time-consuming should happen between bang() and render
 	void bang() {
+		PerfScope perf_scope(perf_stages[PERF_BANG], perf_timing != 0);
+		submit_async_check();
+
 		t_atom a[5];
 
 		// get desired view matrix (from @position and @quat attrs)
 		object_attr_getfloat_array(this, _jit_sym_position, 3, &view_position.x);
 		object_attr_getfloat_array(this, _jit_sym_quat, 4, &view_quat.x);
-		view_mat = glm::translate(glm::mat4(1.0f), view_position) * mat4_cast(view_quat);
+		view_quat = glm::normalize(view_quat);
+		view_pose = Pose(view_quat, view_position);
+
+		// prepare rows (for @tracking_format matrix, or recording) for the driver to fill:
+		tracking_begin();
+		bang_time = PoseChannel::now();
+		filter_update();
 		
 		// TODO: video (or separate message for this?)
 		
 		// TODO: driver poll events
 		if (connected) {
+			PerfScope perf_scope(perf_stages[PERF_DRIVER], perf_timing != 0);
 #ifdef USE_STEAM_DRIVER
 			if (driver == ps_steam) {
 				steam_bang();
@@ -606,22 +1462,37 @@ struct Vr {
 				oculus_bang();
 			}
 #endif
+			if (driver == ps_replay) {
+				replay_bang();
+			}
+			if (driver == ps_sim) {
+				sim_bang();
+			}
 		}
 		else {
 			// perhaps, poll for availability?
 		}
 
+		// send the tracking matrix (and device names, if they changed), and record the frame:
+		tracking_end();
+
+		// share the head pose with audio objects:
+		if (pose_channel) {
+			Pose world = view_pose * head_pose;
+			pose_channel->publish(world.quat, world.position);
+		}
+
 		// always output the tracking space (so we can attach a jit.gl.node if desired)
 		atom_setsym(a, ps_tracking);
 
-		glm::vec3 p = glm::vec3(view_mat[3]); // the translation component
+		glm::vec3 p = view_pose.position;
 		atom_setsym(a, _jit_sym_position);
 		atom_setfloat(a + 1, p.x);
 		atom_setfloat(a + 2, p.y);
 		atom_setfloat(a + 3, p.z);
 		outlet_anything(outlet_tracking, ps_tracking, 4, a);
 
-		glm::quat q = glm::quat_cast(view_mat); // the orientation component
+		glm::quat q = view_pose.quat;
 		atom_setsym(a, _jit_sym_quat);
 		atom_setfloat(a + 1, q.x);
 		atom_setfloat(a + 2, q.y);
@@ -630,16 +1501,27 @@ struct Vr {
 		outlet_anything(outlet_tracking, ps_tracking, 5, a);
 
 		// always output camera poses here (so it works even if not currently tracking)
+		output_eye_poses();
+
+		// the bookkeeping, once the poses are out:
+		if (connected && (render_adapt || (perf_timing && perf_stream))) runtime_stats_update();
+		if (render_adapt && connected) render_scale_adapt();
+		// the stats of the frames so far (this bang's own time is recorded when it returns):
+		if (perf_timing && perf_stream) perf_stream_output();
+	}
+
+	void output_eye_poses() {
+		t_atom a[4];
 		for (int eye = 0; eye < 2; eye++) {
-			glm::mat4 world_mat = view_mat * eye_mat[eye];
+			Pose world = view_pose * eye_pose[eye];
 
-			glm::vec3 p = glm::vec3(world_mat[3]); // the translation component
+			glm::vec3 p = world.position;
 			atom_setfloat(a + 0, p.x);
 			atom_setfloat(a + 1, p.y);
 			atom_setfloat(a + 2, p.z);
 			outlet_anything(outlet_eye[eye], _jit_sym_position, 3, a);
 
-			glm::quat q = glm::quat_cast(world_mat); // the orientation component
+			glm::quat q = world.quat;
 			atom_setfloat(a + 0, q.x);
 			atom_setfloat(a + 1, q.y);
 			atom_setfloat(a + 2, q.z);
@@ -647,7 +1529,611 @@ struct Vr {
 			outlet_anything(outlet_eye[eye], _jit_sym_quat, 4, a);
 		}
 	}
+
+	// late latch: bang() samples the pose, but the patch's own work in response delays the render,
+	// so just before the scene is drawn, the eye poses are predicted again & sent to the cameras,
+	// and the driver told of the newer pose, so that timewarp only corrects the remaining delta
+	// send 'latch' between the patch's logic and the render, or use @schedule with @late_latch
+	// (Oculus only: the SteamVR compositor always reprojects from the WaitGetPoses pose)
+	void latch() {
+		if (!connected) return;
+#ifdef USE_OCULUS_DRIVER
+		if (driver == ps_oculus) {
+			if (oculus_latch()) output_eye_poses();
+		}
+#endif
+	}
+	
+	//////////////////////////////////////////////////////////////////////////////////////
+
+	// @tracking_format matrix: allocate the matrix & dictionary on first use
+	bool tracking_matrix_create() {
+		if (tracking_matrix) return true;
+
+		t_jit_matrix_info info;
+		jit_matrix_info_default(&info);
+		info.type = _jit_sym_float32;
+		info.planecount = 1;
+		info.dimcount = 2;
+		info.dim[0] = TRACKING_COLUMNS;
+		info.dim[1] = VR_MAX_TRACKED_DEVICES;
+		tracking_matrix = jit_object_new(_jit_sym_jit_matrix, &info);
+		if (!tracking_matrix) {
+			object_error(&ob, "failed to create tracking matrix");
+			return false;
+		}
+		tracking_matrix = jit_object_register(tracking_matrix, jit_symbol_unique());
+		tracking_matrix_name = jit_attr_getsym(tracking_matrix, _jit_sym_name);
+		jit_object_method(tracking_matrix, _jit_sym_getinfo, &info);
+		tracking_matrix_stride = info.dimstride[1];
+
+		tracking_dict_name = _jit_sym_nothing;
+		tracking_dict = dictobj_register(dictionary_new(), &tracking_dict_name);
+		// force the names to be sent with the first matrix:
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) tracking_names_sent[i] = _jit_sym_nothing;
+		return true;
+	}
+
+	void tracking_matrix_free() {
+		if (tracking_matrix) {
+			jit_object_free(tracking_matrix);
+			tracking_matrix = 0;
+			tracking_matrix_name = _jit_sym_nothing;
+		}
+		if (tracking_dict) {
+			object_free(tracking_dict);
+			tracking_dict = 0;
+			tracking_dict_name = _jit_sym_nothing;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////
+
+	// fetch the driver's hidden area meshes, and send them
+	// drawn into the depth buffer of the capture before the scene, they let depth testing
+	// discard the fragments that the lenses never show
+	void area_update() {
+		area_mesh[AREA_HIDDEN].clear();
+		area_mesh[AREA_VISIBLE].clear();
+		if (connected) {
+#ifdef USE_STEAM_DRIVER
+			if (driver == ps_steam) steam_area_meshes();
+#endif
+#ifdef USE_OCULUS_DRIVER
+			if (driver == ps_oculus) oculus_area_meshes();
+#endif
+		}
+		area_output(AREA_HIDDEN, gensym("hidden_area"));
+		area_output(AREA_VISIBLE, gensym("visible_area"));
+	}
+
+	void area_output(int which, t_symbol * msg) {
+		const std::vector<glm::vec2>& mesh = area_mesh[which];
+		if (mesh.empty()) return;
+
+		t_jit_matrix_info info;
+		jit_matrix_info_default(&info);
+		info.type = _jit_sym_float32;
+		info.planecount = 3;
+		info.dimcount = 1;
+		info.dim[0] = (long)mesh.size();
+		if (!area_matrix[which]) {
+			area_matrix[which] = jit_object_new(_jit_sym_jit_matrix, &info);
+			if (!area_matrix[which]) {
+				object_error(&ob, "failed to create %s matrix", msg->s_name);
+				return;
+			}
+			area_matrix[which] = jit_object_register(area_matrix[which], jit_symbol_unique());
+		}
+		else {
+			jit_object_method(area_matrix[which], _jit_sym_setinfo, &info);
+		}
+		jit_object_method(area_matrix[which], _jit_sym_getinfo, &info);
+
+		char * data = 0;
+		long savelock = (long)jit_object_method(area_matrix[which], _jit_sym_lock, 1);
+		jit_object_method(area_matrix[which], _jit_sym_getdata, &data);
+		if (data) {
+			for (size_t i = 0; i < mesh.size(); i++) {
+				float * cell = (float *)(data + i * info.dimstride[0]);
+				cell[0] = mesh[i].x;
+				cell[1] = mesh[i].y;
+				cell[2] = 0.f;
+			}
+		}
+		jit_object_method(area_matrix[which], _jit_sym_lock, savelock);
+		if (!data) return;
+
+		t_atom a[2];
+		atom_setsym(a + 0, _jit_sym_jit_matrix);
+		atom_setsym(a + 1, jit_attr_getsym(area_matrix[which], _jit_sym_name));
+		outlet_anything(outlet_msg, msg, 2, a);
+	}
+
+	void area_free() {
+		for (int i = 0; i < 2; i++) {
+			if (area_matrix[i]) {
+				jit_object_free(area_matrix[i]);
+				area_matrix[i] = 0;
+			}
+		}
+	}
+
+	// called at the start of bang(): clear the rows, so that
+	// devices not seen this frame are left with TRACKING_CONNECTED == 0
+	void tracking_begin() {
+		bool matrix = tracking_format == ps_matrix && tracking_matrix_create();
+		tracking_messages = !matrix;
+		tracking_capture = matrix || recording();
+		if (!tracking_capture) return;
+
+		memset(tracking_rows, 0, sizeof(tracking_rows));
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) tracking_names[i] = 0;
+		if (recording()) {
+			record_frame->numevents = 0;
+			memset(record_has_input, 0, sizeof(record_has_input));
+		}
+	}
+
+	// called at the end of bang(): send the matrix, 
+	// plus the device names if the set of devices has changed
+	// and hand the frame to the recorder
+	void tracking_end() {
+		if (!tracking_capture) return;
+		tracking_capture = false;
+
+		if (recording()) record_write();
+		if (tracking_messages) return;
+
+		char * data = 0;
+		long savelock = (long)jit_object_method(tracking_matrix, _jit_sym_lock, 1);
+		jit_object_method(tracking_matrix, _jit_sym_getdata, &data);
+		if (data) {
+			for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+				memcpy(data + i * tracking_matrix_stride, tracking_rows[i], sizeof(tracking_rows[i]));
+			}
+		}
+		jit_object_method(tracking_matrix, _jit_sym_lock, savelock);
+		if (!data) return;
+
+		t_atom a[1];
+		bool names_changed = false;
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+			if (tracking_names[i] != tracking_names_sent[i]) {
+				names_changed = true;
+				break;
+			}
+		}
+		if (names_changed) {
+			char key[8];
+			dictionary_clear(tracking_dict);
+			for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+				tracking_names_sent[i] = tracking_names[i];
+				if (tracking_names[i]) {
+					snprintf(key, sizeof(key), "%d", i);
+					dictionary_appendsym(tracking_dict, gensym(key), tracking_names[i]);
+				}
+			}
+			atom_setsym(a, tracking_dict_name);
+			outlet_anything(outlet_tracking, ps_dictionary, 1, a);
+		}
+
+		atom_setsym(a, tracking_matrix_name);
+		outlet_anything(outlet_tracking, _jit_sym_jit_matrix, 1, a);
+	}
+
+	// returns the row for a device index, marking it as connected & named
+	// returns null if rows are not being captured (neither @tracking_format matrix nor recording)
+	float * tracking_row(int index, t_symbol * id) {
+		if (!tracking_capture || index < 0 || index >= VR_MAX_TRACKED_DEVICES) return 0;
+		float * row = tracking_rows[index];
+		row[TRACKING_CONNECTED] = 1.f;
+		tracking_names[index] = id;
+		return row;
+	}
+
+	static int filter_type(t_symbol * s) {
+		if (s == ps_one_euro) return PoseFilter::ONE_EURO;
+		if (s == ps_kalman) return PoseFilter::KALMAN;
+		return PoseFilter::NONE;
+	}
+
+	// apply the @filter attributes to the slots not set by filter_device
+	void filter_update() {
+		int type = filter_type(filter);
+		float p0 = type == PoseFilter::KALMAN ? filter_process_noise : filter_mincutoff;
+		float p1 = type == PoseFilter::KALMAN ? filter_measurement_noise : filter_beta;
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+			if (filter_custom[i]) continue;
+			PoseFilter& f = filters[i];
+			if (f.type != type) f.reset();
+			f.type = type;
+			f.param[0] = p0;
+			f.param[1] = p1;
+		}
+	}
+
+	// filter_device <index> <none|one_euro|kalman> [param1 param2]: set the filter for one slot
+	// filter_device <index>: revert the slot to the @filter attributes
+	void filter_device(long argc, t_atom * argv) {
+		if (argc < 1) return;
+		int index = (int)atom_getlong(argv);
+		if (index < 0 || index >= VR_MAX_TRACKED_DEVICES) {
+			object_error(&ob, "filter_device: no device slot %d", index);
+			return;
+		}
+		PoseFilter& f = filters[index];
+		f.reset();
+		if (argc < 2) {
+			filter_custom[index] = false;
+			return;
+		}
+		filter_custom[index] = true;
+		f.type = filter_type(atom_getsym(argv + 1));
+		if (f.type == PoseFilter::KALMAN) {
+			f.param[0] = filter_process_noise;
+			f.param[1] = filter_measurement_noise;
+		}
+		else {
+			f.param[0] = filter_mincutoff;
+			f.param[1] = filter_beta;
+		}
+		if (argc > 2) f.param[0] = atom_getfloat(argv + 2);
+		if (argc > 3) f.param[1] = atom_getfloat(argv + 3);
+	}
+
+	// smooth a tracking-space device pose in place; vel & angvel are in tracking space
+	// t is when it was sampled, if not at bang_time (e.g. latched later in the frame)
+	// returns false (leaving pose untouched) if the slot is not filtered
+	bool filter_pose(t_symbol * id, int index, Pose& pose, glm::vec3 const & vel, glm::vec3 const & angvel, double t = -1.) {
+		if (index < 0 || index >= VR_MAX_TRACKED_DEVICES) return false;
+		PoseFilter& f = filters[index];
+		if (f.type == PoseFilter::NONE) return false;
+		if (id == ps_head && !filter_custom[index]) return false;
+		pose = f.apply(pose, vel, angvel, t < 0. ? bang_time : t);
+		return true;
+	}
+
+	// output (and remember) the frustum of an eye
+	void output_frustum(int eye, float l, float r, float b, float t) {
+		t_atom a[6];
+		float * f = eye_frustum[eye];
+		f[0] = l; f[1] = r; f[2] = b; f[3] = t; f[4] = near_clip; f[5] = far_clip;
+		for (int i = 0; i < 6; i++) atom_setfloat(a + i, f[i]);
+		outlet_anything(outlet_eye[eye], ps_frustum, 6, a);
+	}
+
+	// output the raw (tracking space) & world pose of a device
+	// pose is the device pose in tracking space
+	void output_tracked_pose(t_symbol * id, int index, Pose const & pose) {
+		output_tracked_pose(id, index, pose, view_pose * pose);
+	}
+
+	// as above, with the world pose already computed
+	void output_tracked_pose(t_symbol * id, int index, Pose const & pose, Pose const & world) {
+		t_atom a[5];
+
+		glm::vec3 p = pose.position;
+		glm::quat q = pose.quat;
+		// adjusted to world space
+		glm::vec3 p1 = world.position;
+		glm::quat q1 = world.quat;
+
+		if (float * row = tracking_row(index, id)) {
+			row[TRACKING_TRACKED_POSITION + 0] = p.x;
+			row[TRACKING_TRACKED_POSITION + 1] = p.y;
+			row[TRACKING_TRACKED_POSITION + 2] = p.z;
+			row[TRACKING_TRACKED_QUAT + 0] = q.x;
+			row[TRACKING_TRACKED_QUAT + 1] = q.y;
+			row[TRACKING_TRACKED_QUAT + 2] = q.z;
+			row[TRACKING_TRACKED_QUAT + 3] = q.w;
+			row[TRACKING_POSITION + 0] = p1.x;
+			row[TRACKING_POSITION + 1] = p1.y;
+			row[TRACKING_POSITION + 2] = p1.z;
+			row[TRACKING_QUAT + 0] = q1.x;
+			row[TRACKING_QUAT + 1] = q1.y;
+			row[TRACKING_QUAT + 2] = q1.z;
+			row[TRACKING_QUAT + 3] = q1.w;
+		}
+		if (!tracking_messages) return;
+
+		atom_setsym(a + 0, ps_tracked_position);
+		atom_setfloat(a + 1, p.x);
+		atom_setfloat(a + 2, p.y);
+		atom_setfloat(a + 3, p.z);
+		outlet_anything(outlet_tracking, id, 4, a);
+
+		atom_setsym(a + 0, ps_tracked_quat);
+		atom_setfloat(a + 1, q.x);
+		atom_setfloat(a + 2, q.y);
+		atom_setfloat(a + 3, q.z);
+		atom_setfloat(a + 4, q.w);
+		outlet_anything(outlet_tracking, id, 5, a);
+
+		atom_setsym(a + 0, _jit_sym_position);
+		atom_setfloat(a + 1, p1.x);
+		atom_setfloat(a + 2, p1.y);
+		atom_setfloat(a + 3, p1.z);
+		outlet_anything(outlet_tracking, id, 4, a);
+
+		atom_setsym(a + 0, _jit_sym_quat);
+		atom_setfloat(a + 1, q1.x);
+		atom_setfloat(a + 2, q1.y);
+		atom_setfloat(a + 3, q1.z);
+		atom_setfloat(a + 4, q1.w);
+		outlet_anything(outlet_tracking, id, 5, a);
+	}
+
+	// output device velocities
+	// vel & angvel are in tracking space
+	// if send_messages is false, they are only captured in the device row
+	void output_tracked_velocity(t_symbol * id, int index, glm::vec3 vel, glm::vec3 angvel, bool send_messages = true) {
+		// rotated into world space (TODO is this appropriate? rotate or unrotate?)
+		output_world_velocity(id, index, view_pose.rotate(vel), view_pose.rotate(angvel), send_messages);
+	}
+
+	// as above, with velocities already in world space
+	void output_world_velocity(t_symbol * id, int index, glm::vec3 vel, glm::vec3 angvel, bool send_messages = true) {
+		t_atom a[4];
+
+		if (float * row = tracking_row(index, id)) {
+			row[TRACKING_VELOCITY + 0] = vel.x;
+			row[TRACKING_VELOCITY + 1] = vel.y;
+			row[TRACKING_VELOCITY + 2] = vel.z;
+			row[TRACKING_ANGULAR_VELOCITY + 0] = angvel.x;
+			row[TRACKING_ANGULAR_VELOCITY + 1] = angvel.y;
+			row[TRACKING_ANGULAR_VELOCITY + 2] = angvel.z;
+		}
+		if (!tracking_messages || !send_messages) return;
+
+		atom_setsym(a + 0, ps_velocity);
+		atom_setfloat(a + 1, vel.x);
+		atom_setfloat(a + 2, vel.y);
+		atom_setfloat(a + 3, vel.z);
+		outlet_anything(outlet_tracking, id, 4, a);
+
+		atom_setsym(a + 0, ps_angular_velocity);
+		atom_setfloat(a + 1, angvel.x);
+		atom_setfloat(a + 2, angvel.y);
+		atom_setfloat(a + 3, angvel.z);
+		outlet_anything(outlet_tracking, id, 4, a);
+	}
 	
+	//////////////////////////////////////////////////////////////////////////////////////
+
+	// start the @poll_rate thread, if enabled and connected
+	void poll_start() {
+		poll_stop();
+		if (!connected || poll_rate <= 0.) return;
+		if (driver == ps_replay || driver == ps_sim) return; // no live devices to sample
+		
+		if (!poll_rings) poll_rings = new PoseRing[VR_MAX_TRACKED_DEVICES];
+#ifdef USE_STEAM_DRIVER
+		if (driver == ps_steam) {
+			if (!steam.hmd) return;
+			// sample in the same space as WaitGetPoses:
+			std::lock_guard<std::mutex> lock(compositor_mutex);
+			poll_origin = vr::VRCompositor()->GetTrackingSpace();
+		}
+#endif
+		poll_running = 1;
+		if (systhread_create((method)poll_thread_fn, this, 0, 0, 0, &poll_thread)) {
+			object_error(&ob, "failed to create poll thread");
+			poll_running = 0;
+			poll_thread = 0;
+		}
+	}
+
+	void poll_stop() {
+		if (poll_thread) {
+			unsigned int ret;
+			poll_running = 0;
+			systhread_join(poll_thread, &ret);
+			poll_thread = 0;
+		}
+	}
+
+	static void * poll_thread_fn(Vr * x) {
+		x->poll_loop();
+		systhread_exit(0);
+		return NULL;
+	}
+
+	// runs in the poll thread
+	void poll_loop() {
+		auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1. / poll_rate));
+		auto next = std::chrono::steady_clock::now();
+		while (poll_running) {
+			double t = PoseChannel::now();
+#ifdef USE_STEAM_DRIVER
+			if (driver == ps_steam) steam_poll(t);
+#endif
+#ifdef USE_OCULUS_DRIVER
+			if (driver == ps_oculus) oculus_poll(t);
+#endif
+			next += period;
+			auto now = std::chrono::steady_clock::now();
+			if (next < now) next = now; // don't try to catch up after a stall
+			std::this_thread::sleep_until(next);
+		}
+	}
+
+	// name of a device index, as used for tracking output
+	// i is a tracking row (up to VR_MAX_TRACKED_DEVICES), which may be past the driver's own device slots
+	t_symbol * poll_device_name(int i) {
+#ifdef USE_STEAM_DRIVER
+		if (driver == ps_steam) return (i >= 0 && i < (int)vr::k_unMaxTrackedDeviceCount) ? steam.devices[i].id : 0;
+#endif
+#ifdef USE_OCULUS_DRIVER
+		if (driver == ps_oculus) {
+			switch (i) {
+			case 0: return ps_head;
+			case 1: return ps_left_hand;
+			case 2: return ps_right_hand;
+			default: break;
+			}
+		}
+#endif
+		return 0;
+	}
+
+	// outputs <id> sample <time> <x y z> <qx qy qz qw>, in world space
+	void poll_output_sample(t_symbol * id, PoseSample const & s) {
+		t_atom a[9];
+		Pose world = view_pose * Pose(s.quat, s.position);
+		glm::vec3 p = world.position;
+		glm::quat q = world.quat;
+		atom_setsym(a + 0, ps_sample);
+		atom_setfloat(a + 1, s.time);
+		atom_setfloat(a + 2, p.x);
+		atom_setfloat(a + 3, p.y);
+		atom_setfloat(a + 4, p.z);
+		atom_setfloat(a + 5, q.x);
+		atom_setfloat(a + 6, q.y);
+		atom_setfloat(a + 7, q.z);
+		atom_setfloat(a + 8, q.w);
+		outlet_anything(outlet_tracking, id, 9, a);
+	}
+
+	// output all samples since the last poll
+	void poll() {
+		if (!poll_rings) return;
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+			PoseRing& ring = poll_rings[i];
+			t_symbol * id = poll_device_name(i);
+			uint32_t h = ring.written();
+			uint32_t lo = ring.oldest();
+			if (ring.tail < lo) ring.tail = lo; // we fell behind
+			for (; id && ring.tail != h; ring.tail++) {
+				PoseSample s;
+				if (ring.read(ring.tail, s)) poll_output_sample(id, s);
+			}
+			ring.tail = h;
+		}
+	}
+
+	// output the most recent sample of each device
+	void poll_latest() {
+		if (!poll_rings) return;
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+			PoseRing& ring = poll_rings[i];
+			t_symbol * id = poll_device_name(i);
+			uint32_t h = ring.written();
+			PoseSample s;
+			if (id && h && ring.read(h - 1, s)) poll_output_sample(id, s);
+		}
+	}
+
+	// output each device's pose at time t (seconds on the sample clock),
+	// or if t <= 0, at -t seconds ago
+	void poll_at(double t) {
+		if (!poll_rings) return;
+		if (t <= 0.) t += PoseChannel::now();
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+			t_symbol * id = poll_device_name(i);
+			PoseSample s;
+			if (id && poll_rings[i].read_at(t, s)) poll_output_sample(id, s);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////
+
+	// record <file>: start recording each bang() to a session file
+	// (a relative name is resolved against the patcher's folder)
+	void record(t_symbol * name) {
+		record_stop();
+		if (name == _jit_sym_nothing) {
+			object_error(&ob, "record: no file name");
+			return;
+		}
+		char fullpath[MAX_PATH_CHARS], native[MAX_PATH_CHARS];
+		if (path_topotentialname(path_getdefault(), name->s_name, fullpath, 0)) {
+			strncpy(fullpath, name->s_name, MAX_PATH_CHARS - 1);
+			fullpath[MAX_PATH_CHARS - 1] = 0;
+		}
+		path_nameconform(fullpath, native, PATH_STYLE_NATIVE, PATH_TYPE_BOOT);
+
+		if (!recorder) recorder = new SessionWriter;
+		if (!record_frame) record_frame = new SessionFrame;
+		if (!recorder->open(native, TRACKING_COLUMNS)) {
+			object_error(&ob, "record: couldn't open %s", native);
+			return;
+		}
+		record_start = PoseChannel::now();
+		record_frame->numevents = 0;
+
+		t_atom a[1];
+		atom_setlong(a, 1);
+		outlet_anything(outlet_msg, ps_record, 1, a);
+	}
+
+	// stop: finish the recording (writes the seek index), and report any dropped frames
+	void record_stop() {
+		if (!recorder || !recorder->is_open()) return;
+		recorder->close();
+
+		t_atom a[3];
+		atom_setlong(a + 0, 0);
+		atom_setlong(a + 1, recorder->frames());
+		atom_setlong(a + 2, recorder->dropped());
+		outlet_anything(outlet_msg, ps_record, 3, a);
+		if (recorder->dropped()) {
+			object_warn(&ob, "record: %d frames dropped (disk too slow)", recorder->dropped());
+		}
+	}
+
+	// called from tracking_end() in bang(); never blocks
+	void record_write() {
+		if (!recorder->is_open()) return;
+		SessionFrame& frame = *record_frame;
+		frame.time = PoseChannel::now() - record_start;
+		for (int eye = 0; eye < 2; eye++) {
+			float * e = frame.eyes[eye];
+			glm::vec3 p = eye_pose[eye].position;
+			glm::quat q = eye_pose[eye].quat;
+			e[0] = p.x; e[1] = p.y; e[2] = p.z;
+			e[3] = q.x; e[4] = q.y; e[5] = q.z; e[6] = q.w;
+			memcpy(e + 7, eye_frustum[eye], sizeof(eye_frustum[eye]));
+		}
+		frame.numdevices = 0;
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+			if (!tracking_names[i]) continue;
+			SessionDevice& dev = frame.devices[frame.numdevices++];
+			dev.index = i;
+			dev.name = tracking_names[i]->s_name;
+			memcpy(dev.row, tracking_rows[i], sizeof(tracking_rows[i]));
+			dev.has_input = record_has_input[i];
+			if (dev.has_input) memcpy(dev.input, record_inputs[i], sizeof(dev.input));
+		}
+		recorder->write(frame);
+	}
+
+	// the recorder stays allocated once used, so check that it has a file open:
+	bool recording() const { return recorder && recorder->is_open(); }
+
+	// driver events (called while polling events in bang())
+	// data is the event's payload (e.g. vr::VREvent_t::data), of which up to SESSION_EVENT_DATA bytes are kept
+	void record_event(uint32_t type, uint32_t device, float age = 0.f, const void * data = 0, size_t size = 0) {
+		SessionFrame& frame = *record_frame;
+		if (frame.numevents < SESSION_MAX_EVENTS) {
+			SessionEvent& event = frame.events[frame.numevents++];
+			event.type = type;
+			event.device = device;
+			event.age = age;
+			memset(event.data, 0, SESSION_EVENT_DATA);
+			if (data) memcpy(event.data, data, AL_MIN(size, (size_t)SESSION_EVENT_DATA));
+		}
+	}
+
+	// the raw input words (SESSION_INPUT_*) of a tracking row, cleared for the driver to fill in,
+	// or 0 if not recording
+	uint32_t * record_input(int index) {
+		if (!recording() || index < 0 || index >= VR_MAX_TRACKED_DEVICES) return 0;
+		record_has_input[index] = true;
+		memset(record_inputs[index], 0, sizeof(record_inputs[index]));
+		return record_inputs[index];
+	}
+
 	// triggered by "jit_gl_texture" message:
 	// submit a texture received from Max to the HMD
 	// the texture would typically be a captured jit.gl.node,
@@ -663,200 +2149,415 @@ struct Vr {
 			object_error(&ob, "%s is not a texture object", intexture->s_name);
 			return;	// no texture to copy from.
 		}
+		submit_async_check();
 		if (connected) {
-			if (is_gl3) {
+			double t0 = PoseChannel::now();
+			{
+				PerfScope perf_scope(perf_stages[PERF_TEXTURE], perf_timing != 0);
+				submit_texture(intexture, jit_texture);
+			}
+			submit_time_update(1000. * (PoseChannel::now() - t0));
+
+			// whichever path submit_texture took:
+			mirror_output();
+		}
+	}
+
+	// hand the texture to the driver, by whichever path it allows (see @submit_path)
+	void submit_texture(t_symbol * intexture, void * jit_texture) {
+		// if connect() completed outside of the GL context, nothing has been made yet:
+		create_gpu_resources();
+		if (is_gl3) {
+			if (!gl3_texture) {
+				t_symbol* context = object_attr_getsym(this, gensym("drawto"));
+				gl3_texture = jit_object_new(ps_jit_gl_texture, context);
 				if (!gl3_texture) {
-					t_symbol* context = object_attr_getsym(this, gensym("drawto"));
-					gl3_texture = jit_object_new(ps_jit_gl_texture, context);
-					if (!gl3_texture) {
-						object_error((t_object*)this, "failed to create texture");
-						return;
-					}
-					object_attr_setlong(gl3_texture, gensym("rectangle"), 0);
-					object_attr_setlong_array(gl3_texture, _jit_sym_dim, 2, fbo_dim);
-					object_attr_setlong(gl3_texture, gensym("gltarget"), GL_TEXTURE_2D);
+					object_error((t_object*)this, "failed to create texture");
+					return;
+				}
+				object_attr_setlong(gl3_texture, gensym("adapt"), 0);
+				object_attr_setlong(gl3_texture, gensym("rectangle"), 0);
+				object_attr_setlong_array(gl3_texture, _jit_sym_dim, 2, fbo_dim);
+				object_attr_setlong(gl3_texture, gensym("gltarget"), GL_TEXTURE_2D);
+			}
+#ifdef USE_STEAM_DRIVER
+			if (driver == ps_steam) {
+				if (steam_can_submit_directly(jit_texture)) {
+					steam_submit_texture(object_attr_getlong(jit_texture, ps_glid), false);
+					set_submit_path(ps_direct);
+					return;
 				}
+				set_submit_path(ps_gl3_copy);
+				gl3_copy_texture(gl3_texture, intexture);
+				steam.fbo_texture_id = jit_attr_getlong(gl3_texture, ps_glid);
+				if (steam.fbo_texture_id) {
+					steam_submit_texture();
+				}
+				else {
+					object_error((t_object*)this, "failed to copy texture");
+				}
+			}
+#endif
+#ifdef USE_OCULUS_DRIVER
+			if (driver == ps_oculus) {
+				oculus_create_gpu_resources();
+				if (!oculus_submit_texture_gl3(intexture, object_attr_getlong(jit_texture, ps_glid))) {
+					object_error(&ob, "problem submitting texture");
+				}
+			}
+#endif
+			return;
+		}
+
+		// get input properties:
+		GLuint input_texture_id = object_attr_getlong(jit_texture, ps_glid);
+		t_atom_long input_texture_dim[2];
+		object_attr_getlong_array(jit_texture, _jit_sym_dim, 2, input_texture_dim);
+
+		// the layers are submitted along with the scene, so must be ready first
+		layers_update();
+
+
+#ifdef USE_STEAM_DRIVER
+		if (driver == ps_steam && steam_can_submit_directly(jit_texture)) {
+			steam_submit_texture(input_texture_id, false);
+			set_submit_path(ps_direct);
+			return;
+		}
+#endif
+
+		// submit it to the driver
+		if (!fbo_id) {
+			// TODO try to allocate FBO for copying Jitter texture to driver?
+			create_gpu_resources();
+			if (!fbo_id) {
+				// just bug out at this point?
+				object_error(&ob, "no fbo yet");
+				return;	// no texture to copy from.
+			}
+		}
+
+		// TODO driver specific
+#ifdef USE_STEAM_DRIVER
+		if (driver == ps_steam) {
+			set_submit_path(ps_copy);
+			if (!steam_copy_texture(input_texture_id, input_texture_dim)) {
+				object_error(&ob, "problem submitting texture");
+			}
+			else if (!(submit_async && steam_push_submit_texture())) {
+				steam_submit_texture();
+				steam_fence_submit_texture();
+			}
+		}
+#endif
+#ifdef USE_OCULUS_DRIVER
+		if (driver == ps_oculus) {
+			if (!oculus_submit_texture(input_texture_id, input_texture_dim)) {
+				object_error(&ob, "problem submitting texture");
+			}
+		}
+#endif
+	}
+
+	// CPU time spent in submit_texture, smoothed, so that the submit paths can be compared
+	void submit_time_update(double ms) {
+		if (submit_time <= 0.) submit_time = ms;
+		submit_time += 0.1 * (ms - submit_time);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////
+
+	// start the submit thread if needed; must be called in the GL context it will share
+	// only the copy paths use it (SteamVR's direct & gl3_copy paths submit a Jitter texture, which the next frame may overwrite)
+	bool submit_async_start() {
+		if (submit_worker.is_running()) return true;
+		if (!submit_worker.start(this, submit_async_fn, &perf_stages[PERF_ASYNC])) {
+			object_error(&ob, "failed to create the submit thread's GL context; submitting from the main thread");
+			submit_async = 0;
+			object_attr_touch(&ob, gensym("submit_async"));
+			return false;
+		}
+		return true;
+	}
+
+	// submits anything still queued first
+	void submit_async_stop() {
+		submit_worker.stop();
+		submit_queue = 0;
+	}
+
+	// fence the GL commands that produced this frame, and queue it for the submit thread
+	// returns false if it must be submitted from the main thread after all
+	bool submit_async_push(SubmitJob const& job) {
+		if (!submit_async_start()) return false;
+		PerfScope perf_scope(perf_stages[PERF_SUBMIT], perf_timing != 0);
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		// the fence is only visible to the submit thread's context once flushed:
+		glFlush();
+		bool waited = false;
+		if (!submit_worker.push(job, fence, waited)) {
+			glDeleteSync(fence);
+			object_error(&ob, "the submit thread could not use its GL context; submitting from the main thread");
+			submit_async = 0;
+			object_attr_touch(&ob, gensym("submit_async"));
+			return false;
+		}
+		if (waited) submit_waits++;
+		submit_queue = submit_worker.depth();
+		submit_wait_time = submit_worker.wait_time();
+		return true;
+	}
+
+	// wait for the submit thread to finish what is queued, e.g. so that a submit from the main thread can't overtake it
+	void submit_async_drain() {
+		if (submit_worker.is_running() && submit_worker.wait_idle()) submit_waits++;
+	}
+
+	// the submit thread can't disconnect, so leaves it to the main thread
+	void submit_async_check() {
+		if (submit_lost.exchange(0)) {
+			object_error(&ob, "fatal error connection lost.");
+			disconnect();
+		}
+	}
+
+	// runs in the submit thread, with its GL context current
+	static void submit_async_fn(void * owner, SubmitJob& job) {
+		Vr * x = (Vr *)owner;
+#ifdef USE_STEAM_DRIVER
+		if (job.driver == ps_steam) x->steam_submit_job(job);
+#endif
+#ifdef USE_OCULUS_DRIVER
+		if (job.driver == ps_oculus) x->oculus_submit_job(job);
+#endif
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////
+
+	// a jit.gl.texture that borrows a texture owned by the driver, so that it can be used in the patch without a copy
+	void * texture_wrap(GLuint glid, t_atom_long dim[2]) {
+		t_symbol * context = object_attr_getsym(this, gensym("drawto"));
+		void * tex = jit_object_new(ps_jit_gl_texture, context);
+		if (!tex) return 0;
+		// a copy into it mustn't resize (i.e. reallocate) the driver's texture:
+		object_attr_setlong(tex, gensym("adapt"), 0);
+		object_attr_setlong(tex, gensym("rectangle"), 0);
+		object_attr_setlong_array(tex, _jit_sym_dim, 2, dim);
+		object_attr_setlong(tex, gensym("gltarget"), GL_TEXTURE_2D);
+		object_attr_setlong(tex, ps_glid, glid);
+		return tex;
+	}
+
+	void texture_unwrap(void * tex) {
+		if (!tex) return;
+		// hand the glid back before freeing, so that the wrapper doesn't delete the driver's texture
+		object_attr_setlong(tex, ps_glid, 0);
+		jit_object_free(tex);
+	}
+
+	// once per submitted frame, after the submit (so, in the GL context):
+	// 'mirror <texture>' (or 'mirror <left> <right>'), for as long as @mirror is on
+	void mirror_output() {
+		mirror_update();
+		if (mirror_count) outlet_anything(outlet_msg, ps_mirror, mirror_count, mirror_names);
+	}
+
+	// must be called in the GL context
+	void mirror_update() {
+		if (!mirror_dirty) return;
+		mirror_dirty = false;
+		mirror_release();
+		if (mirror == _jit_sym_nothing || mirror == gensym("none")) return;
+#ifdef USE_STEAM_DRIVER
+		if (driver == ps_steam) steam_mirror_create();
+#endif
+#ifdef USE_OCULUS_DRIVER
+		if (driver == ps_oculus) oculus_mirror_create();
+#endif
+	}
+
+	bool mirror_add(GLuint glid) {
+		GLint w = 0, h = 0;
+		glBindTexture(GL_TEXTURE_2D, glid);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		t_atom_long dim[2] = { AL_MAX(w, 1), AL_MAX(h, 1) };
+		void * tex = texture_wrap(glid, dim);
+		if (!tex) {
+			object_error(&ob, "failed to create mirror texture");
+			return false;
+		}
+		mirror_textures[mirror_count] = tex;
+		atom_setsym(mirror_names + mirror_count, object_attr_getsym(tex, gensym("name")));
+		mirror_count++;
+		return true;
+	}
+
+	void mirror_release() {
+		for (int i = 0; i < mirror_count; i++) {
+			texture_unwrap(mirror_textures[i]);
+			mirror_textures[i] = 0;
+		}
+		mirror_count = 0;
 #ifdef USE_STEAM_DRIVER
-				if (driver == ps_steam) {
-					gl3_copy_texture(intexture);
-					steam.fbo_texture_id = jit_attr_getlong(gl3_texture, ps_glid);
-					if (steam.fbo_texture_id) {
-						steam_submit_texture();
-					}
-					else {
-						object_error((t_object*)this, "failed to copy texture");
-					}
-				}
+		steam_mirror_release();
 #endif
 #ifdef USE_OCULUS_DRIVER
-				if (driver == ps_oculus) {
-					oculus_create_gpu_resources();
-					if (!oculus_submit_texture_gl3(intexture)) {
-						object_error(&ob, "problem submitting texture");
-					}
-				}
+		oculus_mirror_release();
 #endif
-				return;
-			}
-
-			// get input properties:
-			GLuint input_texture_id = object_attr_getlong(jit_texture, ps_glid);
-			t_atom_long input_texture_dim[2];
-			object_attr_getlong_array(jit_texture, _jit_sym_dim, 2, input_texture_dim);
+	}
+	
+	//////////////////////////////////////////////////////////////////////////////////////
 
+	// bring the driver resources & content of every vr.layer up to date, before the scene is submitted
+	// must be called in the GL context
+	// (not with the gl3 engine, which has no fbo to copy with)
+	void layers_update() {
+		if (!layer_registry || !fbo_read_id) return;
+		if (!layer_fbo_id) glGenFramebuffersEXT(1, &layer_fbo_id);
+		for (int i = 0; i < VR_MAX_LAYERS; i++) {
+			LayerState & state = layer_states[i];
+			if (state.generation != layer_registry->generations[i]) {
+				// a different vr.layer (or none) is in this slot now
+				layer_release(i);
+				state.generation = layer_registry->generations[i];
+			}
+			Layer * layer = layer_registry->slots[i];
+			void * jit_texture = (layer && layer->texture) ? jit_object_findregistered(gensym(layer->texture)) : 0;
+			if (!jit_texture || object_classname(jit_texture) != ps_jit_gl_texture) {
+				layer_hide(i);
+				continue;
+			}
+			GLuint glid = object_attr_getlong(jit_texture, ps_glid);
+			t_atom_long dim[2];
+			object_attr_getlong_array(jit_texture, _jit_sym_dim, 2, dim);
+			if (!glid || dim[0] < 1 || dim[1] < 1) {
+				layer_hide(i);
+				continue;
+			}
+			GLenum target = object_attr_getlong(jit_texture, gensym("rectangle")) ? GL_TEXTURE_RECTANGLE_ARB : GL_TEXTURE_2D;
 
-			// submit it to the driver
-			if (!fbo_id) {
-				// TODO try to allocate FBO for copying Jitter texture to driver?
-				create_gpu_resources();
-				if (!fbo_id) {
-					// just bug out at this point?
-					object_error(&ob, "no fbo yet");
-					return;	// no texture to copy from.
-				}
+			// is the content due to be copied again?
+			bool due;
+			if (state.last < 0. || dim[0] != state.dim[0] || dim[1] != state.dim[1] || layer->is_static != state.is_static) {
+				due = true;
+			}
+			else if (layer->is_static) {
+				due = layer->serial != state.serial;
+			}
+			else {
+				due = layer->rate <= 0. || (bang_time - state.last) >= 1. / layer->rate;
 			}
 
-			// TODO driver specific
+			// the drivers want the pose in tracking space:
+			Pose pose(layer->quat, layer->position);
+			if (!layer->head_locked) pose = view_pose.inverse() * pose;
+			float height = layer->width * dim[1] / float(dim[0]);
+
+			bool copied = false;
 #ifdef USE_STEAM_DRIVER
 			if (driver == ps_steam) {
-				if (!steam_copy_texture(input_texture_id, input_texture_dim)) {
-					object_error(&ob, "problem submitting texture");
-				}
-				else {
-					steam_submit_texture();
-				}
+				state.visible = steam_layer_update(i, layer, glid, target, dim, due, pose, copied);
 			}
 #endif
 #ifdef USE_OCULUS_DRIVER
 			if (driver == ps_oculus) {
-				if (!oculus_submit_texture(input_texture_id, input_texture_dim)) {
-					object_error(&ob, "problem submitting texture");
-				}
+				state.visible = oculus_layer_update(i, layer, glid, target, dim, due, pose, height, copied);
 			}
 #endif
+			if (copied) {
+				state.serial = layer->serial;
+				state.is_static = layer->is_static;
+				state.last = bang_time;
+			}
 		}
-		
-		t_atom a[1];
-		if (connected) {
-			// TODO: output mirror textures here if desired?
+	}
+
+	void layer_hide(int i) {
+		LayerState & state = layer_states[i];
+		state.visible = false;
+#ifdef USE_STEAM_DRIVER
+		if (state.overlay != vr::k_ulOverlayHandleInvalid && steam.hmd && vr::VROverlay()) {
+			std::lock_guard<std::mutex> lock(compositor_mutex);
+			vr::VROverlay()->HideOverlay(state.overlay);
+		}
+#endif
+	}
+
+	void layer_release(int i) {
+		LayerState & state = layer_states[i];
+#ifdef USE_OCULUS_DRIVER
+		if (state.chain && oculus.session) ovr_DestroyTextureSwapChain(oculus.session, state.chain);
+#endif
+#ifdef USE_STEAM_DRIVER
+		if (state.overlay != vr::k_ulOverlayHandleInvalid && steam.hmd && vr::VROverlay()) {
+			std::lock_guard<std::mutex> lock(compositor_mutex);
+			vr::VROverlay()->DestroyOverlay(state.overlay);
+		}
+#endif
+		if (state.texture) glDeleteTextures(1, &state.texture);
+		state.chain = 0;
+		state.chain_committed = false;
+		state.overlay = vr::k_ulOverlayHandleInvalid;
+		state.texture = 0;
+		state.dim[0] = state.dim[1] = 0;
+		state.last = -1.;
+		state.visible = false;
+	}
+
+	void layers_release() {
+		for (int i = 0; i < VR_MAX_LAYERS; i++) layer_release(i);
+		if (layer_fbo_id) {
+			glDeleteFramebuffersEXT(1, &layer_fbo_id);
+			layer_fbo_id = 0;
 		}
 	}
 	
 	//////////////////////////////////////////////////////////////////////////////////////
 	
-	void gl3_copy_texture(t_symbol * intexture) {
+	void set_submit_path(t_symbol * path) {
+		if (submit_path != path) {
+			submit_path = path;
+			object_attr_touch(&ob, gensym("submit_path"));
+			// whether the render scale applies may have changed:
+			render_scale_update();
+		}
+	}
+
+	// copy intexture into dest (a jit.gl.texture with @adapt 0, so that it keeps the driver's size),
+	// by calling its jit_gl_texture method
+	void gl3_copy_texture(void * dest, t_symbol * intexture) {
+		PerfScope perf_scope(perf_stages[PERF_COPY], perf_timing != 0);
 		t_atom a;
 		atom_setsym(&a, intexture);
-		jit_object_method_typed(gl3_texture, ps_jit_gl_texture, 1, &a, NULL);
+		jit_object_method_typed(dest, ps_jit_gl_texture, 1, &a, NULL);
 	}
 
+	// copy a (rectangle) Jitter texture into a 2D driver texture
+	// flipY: reverse the rows
+	// input_target: GL_TEXTURE_2D for a Jitter texture with @rectangle 0 (which only the blit can copy)
 	bool fbo_copy_texture(GLuint 		input_texture_id, 
 							 t_atom_long 	input_texture_dim[2],
 							 GLuint 		fbo_id, 
 							 GLuint 		fbo_texture_id, 
 							 t_atom_long 	fbo_dim[2],
-							 bool flipY = true) {
-		// copy our glid source into the inFBO destination
-		// save some state
-		GLint previousFBO;	// make sure we pop out to the right FBO
-		GLint previousMatrixMode;
-
-		glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &previousFBO);
-		glGetIntegerv(GL_MATRIX_MODE, &previousMatrixMode);
-
-		// save texture state, client state, etc.
-		glPushAttrib(GL_ALL_ATTRIB_BITS);
-		glPushClientAttrib(GL_CLIENT_ALL_ATTRIB_BITS);
-
-		// TODO use rectangle 1?
-		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo_id);
-		glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, fbo_texture_id, 0);
-		if (fbo_check()) {
-			glMatrixMode(GL_TEXTURE);
-			glPushMatrix();
-			glLoadIdentity();
-
-			glViewport(0, 0, fbo_dim[0], fbo_dim[1]);
-			
-			glMatrixMode(GL_PROJECTION);
-			glPushMatrix();
-			glLoadIdentity();
-			if (flipY) {
-				glOrtho(0.0, fbo_dim[0], 0.0, fbo_dim[1], -1, 1);
-			}
-			else {
-				glOrtho(0.0, fbo_dim[0], fbo_dim[1], 0., -1, 1);
-			}
-
-			glMatrixMode(GL_MODELVIEW);
-			glPushMatrix();
-			glLoadIdentity();
-
-			glClearColor(0, 0, 0, 1);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			glActiveTexture(GL_TEXTURE0);
-			glClientActiveTexture(GL_TEXTURE0);
-			glEnable(GL_TEXTURE_RECTANGLE_ARB);
-			glBindTexture(GL_TEXTURE_RECTANGLE_ARB, input_texture_id);
-			
-			// do not need blending if we use black border for alpha and replace env mode, saves a buffer wipe
-			// we can do this since our image draws over the complete surface of the FBO, no pixel goes untouched.
-
-			glDisable(GL_BLEND);
-			glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-
-			// move to VA for rendering
-			// TODO flip vertical?
-			GLfloat tex_coords[] = {
-				(GLfloat)input_texture_dim[0], 0.f,
-				0.0, 0.f,
-				0.0, (GLfloat)input_texture_dim[1],
-				(GLfloat)input_texture_dim[0], (GLfloat)input_texture_dim[1]
-			};
-
-			GLfloat verts[] = {
-				(GLfloat)fbo_dim[0], (GLfloat)fbo_dim[1],
-				0.0, (GLfloat)fbo_dim[1],
-				0.0, 0.0,
-				(GLfloat)fbo_dim[0], 0.0
-			};
-			
-			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-			glTexCoordPointer(2, GL_FLOAT, 0, tex_coords);
-			glEnableClientState(GL_VERTEX_ARRAY);
-			glVertexPointer(2, GL_FLOAT, 0, verts);
-			glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-			glDisableClientState(GL_VERTEX_ARRAY);
-			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-
-			glBindTexture(GL_TEXTURE_RECTANGLE_ARB, 0);
-
-			glMatrixMode(GL_MODELVIEW);
-			glPopMatrix();
-			glMatrixMode(GL_PROJECTION);
-			glPopMatrix();
-
-			glMatrixMode(GL_TEXTURE);
-			glPopMatrix();
-		}
-		else {
-			object_error(&ob, "falied to create submit FBO");
+							 bool flipY = true,
+							 GLenum 		input_target = GL_TEXTURE_RECTANGLE_ARB) {
+		GLint indim[2] = { (GLint)input_texture_dim[0], (GLint)input_texture_dim[1] };
+		GLint outdim[2] = { (GLint)fbo_dim[0], (GLint)fbo_dim[1] };
+		// the blit (see vr_copy.h), else the fixed-function fallback:
+		if (fbo_read_id && vr_blit_texture(fbo_read_id, input_texture_id, input_target, indim, fbo_id, fbo_texture_id, outdim, flipY)) return true;
+		if (input_target != GL_TEXTURE_RECTANGLE_ARB) return false;
+		GLenum status = vr_draw_texture(input_texture_id, indim, fbo_id, fbo_texture_id, outdim, flipY);
+		if (!fbo_check(status)) {
+			object_error(&ob, "failed to create submit FBO");
 			return false;
 		}
-		
-		// tidy up:
-		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
-		glPopAttrib();
-		glPopClientAttrib();
-		glMatrixMode(previousMatrixMode);
-		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, previousFBO);		
-		
 		return true;
 	}
-	
-	bool fbo_check() {
-		GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+
+	bool fbo_check(GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT)) {
 		if (status != GL_FRAMEBUFFER_COMPLETE_EXT) {
 			if (status == GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT_EXT) {
 				object_error(&ob, "failed to create render to texture target GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT");
@@ -890,7 +2591,7 @@ struct Vr {
 		oculus_initialized = 0;
 	}
 
-	bool oculus_is_available() {
+	static bool oculus_is_available() {
 		ovrDetectResult res = ovr_Detect(250); // ms timeout
 		return (res.IsOculusServiceRunning && res.IsOculusHMDConnected);
 	}
@@ -1054,7 +2755,7 @@ struct Vr {
 		// Initialize our single full screen Fov layer.
 		// (needs to happen after textureset_create)
 		oculus.layer.Header.Type = ovrLayerType_EyeFov;
-		oculus.layer.Header.Flags = 0;// ovrLayerFlag_TextureOriginAtBottomLeft;   // Because OpenGL. was 0.
+		oculus.layer.Header.Flags = 0; // set per frame, by oculus_set_origin()
 		oculus.layer.Viewport[0].Pos.x = 0;
 		oculus.layer.Viewport[0].Pos.y = 0;
 		oculus.layer.Viewport[0].Size.w = recommenedTex0Size.w;
@@ -1084,6 +2785,47 @@ struct Vr {
 		VR_DEBUG_POST("oculus configured");
 	}
 
+	// approximate the hidden & visible areas from each eye's FOV tangents (see OCULUS_VISIBLE_RADIUS)
+	void oculus_area_meshes() {
+		for (int eye = 0; eye < 2; eye++) {
+			// the same FOV that oculus_bang() renders with:
+			const ovrFovPort& fov = oculus.max_fov ? oculus.hmd.MaxEyeFov[eye] : oculus.hmd.DefaultEyeFov[eye];
+			float width = fov.LeftTan + fov.RightTan, height = fov.DownTan + fov.UpTan;
+			if (width <= 0.f || height <= 0.f) continue;
+			// the optical axis, in the eye's texture coordinates:
+			glm::vec2 center(fov.LeftTan / width, fov.DownTan / height);
+
+			glm::vec2 inner[OCULUS_VISIBLE_SEGMENTS], outer[OCULUS_VISIBLE_SEGMENTS];
+			for (int i = 0; i < OCULUS_VISIBLE_SEGMENTS; i++) {
+				float angle = 6.2831853f * i / OCULUS_VISIBLE_SEGMENTS;
+				float c = cosf(angle), s = sinf(angle);
+				glm::vec2 tan(c * (c < 0.f ? fov.LeftTan : fov.RightTan), s * (s < 0.f ? fov.DownTan : fov.UpTan));
+				glm::vec2 dir(tan.x / width, tan.y / height);
+				// where the ray from the center leaves the texture:
+				float tx = dir.x > 0.f ? (1.f - center.x) / dir.x : dir.x < 0.f ? -center.x / dir.x : 1e30f;
+				float ty = dir.y > 0.f ? (1.f - center.y) / dir.y : dir.y < 0.f ? -center.y / dir.y : 1e30f;
+				float edge = AL_MIN(tx, ty);
+				outer[i] = center + dir * edge;
+				inner[i] = center + dir * AL_MIN(OCULUS_VISIBLE_RADIUS, edge);
+			}
+			float x0 = 0.5f * eye;
+			for (int i = 0; i < OCULUS_VISIBLE_SEGMENTS; i++) {
+				int j = (i + 1) % OCULUS_VISIBLE_SEGMENTS;
+				glm::vec2 c = center, a = inner[i], b = inner[j], oa = outer[i], ob = outer[j];
+				// side-by-side:
+				c.x = x0 + 0.5f * c.x; a.x = x0 + 0.5f * a.x; b.x = x0 + 0.5f * b.x;
+				oa.x = x0 + 0.5f * oa.x; ob.x = x0 + 0.5f * ob.x;
+
+				std::vector<glm::vec2>& visible = area_mesh[AREA_VISIBLE];
+				visible.push_back(c); visible.push_back(a); visible.push_back(b);
+				if (a == oa && b == ob) continue; // this segment reaches the edge
+				std::vector<glm::vec2>& hidden = area_mesh[AREA_HIDDEN];
+				hidden.push_back(a); hidden.push_back(oa); hidden.push_back(ob);
+				hidden.push_back(a); hidden.push_back(ob); hidden.push_back(b);
+			}
+		}
+	}
+
 	// intensity in 0.f..1.f
 	void oculus_haptic(int hand, float intensity = 0.5f) {
 		if (!oculus.session) return;
@@ -1116,22 +2858,98 @@ struct Vr {
 				return false;
 			}
 
-			// unused?
-			int length = 0;
-			ovr_GetTextureSwapChainLength(oculus.session, oculus.textureChain, &length);
-
 			// we can update the layer too here:
 			oculus.layer.ColorTexture[0] = oculus.textureChain;
 			oculus.layer.ColorTexture[1] = oculus.textureChain;
 
+			oculus_create_chain_textures();
+
 			VR_DEBUG_POST("oculus gpu resources created");
 
 		}
 		return true;
 	}
 
+	// wrap each buffer of the swap chain in a jit.gl.texture, once per chain
+	// the buffers are owned by LibOVR; the wrappers only borrow their glids
+	void oculus_create_chain_textures() {
+		int length = 0;
+		ovr_GetTextureSwapChainLength(oculus.session, oculus.textureChain, &length);
+		if (length > OCULUS_MAX_CHAIN_LENGTH) {
+			object_warn(&ob, "texture chain has %d buffers, only %d can be rendered to directly", length, OCULUS_MAX_CHAIN_LENGTH);
+			length = OCULUS_MAX_CHAIN_LENGTH;
+		}
+		oculus.chainLength = 0;
+		for (int i = 0; i < length; i++) {
+			GLuint glid = 0;
+			ovr_GetTextureSwapChainBufferGL(oculus.session, oculus.textureChain, i, &glid);
+			void * tex = texture_wrap(glid, fbo_dim);
+			if (!tex) {
+				object_warn(&ob, "failed to wrap texture chain; scene textures will be copied");
+				break;
+			}
+			oculus.chainTextures[i] = tex;
+			oculus.chainNames[i] = object_attr_getsym(tex, gensym("name"));
+			oculus.chainIds[i] = glid;
+			oculus.chainLength++;
+		}
+	}
+
+	void oculus_release_chain_textures() {
+		for (int i = 0; i < oculus.chainLength; i++) {
+			texture_unwrap(oculus.chainTextures[i]);
+			oculus.chainTextures[i] = 0;
+		}
+		oculus.chainLength = 0;
+	}
+
+	// tell the patch which texture to render the next frame into
+	// route "swapchain" to the capture target of the jit.gl.node, and send that texture back in;
+	// vr then recognizes it as the current chain buffer, and only commits & submits it
+	void oculus_output_chain_texture() {
+		if (!oculus.textureChain || !oculus.chainLength) return;
+		int curIndex = 0;
+		ovr_GetTextureSwapChainCurrentIndex(oculus.session, oculus.textureChain, &curIndex);
+		if (curIndex < 0 || curIndex >= oculus.chainLength) return;
+		t_atom a[1];
+		atom_setsym(a, oculus.chainNames[curIndex]);
+		outlet_anything(outlet_msg, gensym("swapchain"), 1, a);
+	}
+
+	// the Oculus mirror is a single texture: both eyes side-by-side, or one eye
+	void oculus_mirror_create() {
+		if (!oculus.session) return;
+		ovrMirrorTextureDesc desc = {};
+		desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+		desc.Width = int(fbo_dim[0]);
+		desc.Height = int(fbo_dim[1]);
+		if (mirror == ps_left || mirror == ps_right) {
+			desc.Width /= 2;
+			desc.MirrorOptions = (mirror == ps_left) ? OCULUS_MIRROR_LEFT_EYE_ONLY : OCULUS_MIRROR_RIGHT_EYE_ONLY;
+		}
+		else if (mirror == ps_distorted) {
+			desc.MirrorOptions = OCULUS_MIRROR_POST_DISTORTION;
+		}
+		if (!OVR_SUCCESS(ovr_CreateMirrorTextureGL(oculus.session, &desc, &oculus.mirrorTexture))) {
+			object_error(&ob, "failed to create mirror texture");
+			oculus.mirrorTexture = 0;
+			return;
+		}
+		GLuint glid = 0;
+		ovr_GetMirrorTextureBufferGL(oculus.session, oculus.mirrorTexture, &glid);
+		mirror_add(glid);
+	}
+
+	void oculus_mirror_release() {
+		if (oculus.session && oculus.mirrorTexture) {
+			ovr_DestroyMirrorTexture(oculus.session, oculus.mirrorTexture);
+		}
+		oculus.mirrorTexture = 0;
+	}
+
 	void oculus_release_gpu_resources() {
 		VR_DEBUG_POST("oculus release gpu");
+		oculus_release_chain_textures();
 		if (oculus.session && oculus.textureChain) {
 			ovr_DestroyTextureSwapChain(oculus.session, oculus.textureChain);
 			oculus.textureChain = 0;
@@ -1141,6 +2959,11 @@ struct Vr {
 	void oculus_bang() {
 		if (!oculus.session) return;
 
+		// the chains can't be rendered into, copied into or committed again until the submit thread
+		// has submitted the last frame; this must happen before the current chain buffer is looked up
+		// (see oculus_output_chain_texture), as the node may render straight into it
+		submit_async_drain();
+
 		ovrResult res = ovr_GetSessionStatus(oculus.session, &oculus.status);
 		if (oculus.status.ShouldQuit) {
 			// the HMD display will return to Oculus Home
@@ -1200,6 +3023,8 @@ struct Vr {
 		// Query the HMD for the predicted tracking state
 		double displayMidpointSeconds = ovr_GetPredictedDisplayTime(oculus.session, oculus.frameIndex);
 		ovrTrackingState ts = ovr_GetTrackingState(oculus.session, displayMidpointSeconds, ovrTrue);
+		// when the pose was sampled, for timewarp to correct from:
+		oculus.sensorSampleTime = ovr_GetTimeInSeconds();
 		if (ts.StatusFlags & (ovrStatus_OrientationTracked | ovrStatus_PositionTracked)) {
 
 			// Computes offset eye poses based on headPose returned by ovrTrackingState.
@@ -1213,67 +3038,28 @@ struct Vr {
 				oculus.layer.Fov[eye] = oculus.eyeRenderDesc[eye].Fov;
 				oculus.layer.SensorSampleTime = oculus.sensorSampleTime;
 
-				// get the tracking-space pose & convert to mat4
-				const ovrPosef& pose = oculus.layer.RenderPose[eye];
-				eye_mat[eye] = glm::translate(glm::mat4(1.0f), to_glm(pose.Position))
-					* mat4_cast(to_glm(pose.Orientation));
+				// get the tracking-space pose
+				eye_pose[eye] = to_pose(oculus.layer.RenderPose[eye]);
 
 				// TODO: proj matrix doesn't need to be calculated every frame; only when fov/near/far/layer data changes
 				// projection
 				const ovrFovPort& fov = oculus.layer.Fov[eye];
-				atom_setfloat(a + 0, -fov.LeftTan * near_clip);
-				atom_setfloat(a + 1, fov.RightTan * near_clip);
-				atom_setfloat(a + 2, -fov.DownTan * near_clip);
-				atom_setfloat(a + 3, fov.UpTan * near_clip);
-				atom_setfloat(a + 4, near_clip);
-				atom_setfloat(a + 5, far_clip);
-				outlet_anything(outlet_eye[eye], ps_frustum, 6, a);
+				output_frustum(eye, -fov.LeftTan * near_clip, fov.RightTan * near_clip, -fov.DownTan * near_clip, fov.UpTan * near_clip);
 			}
 		}
 
 		{
+			PerfScope perf_scope(perf_stages[PERF_OUTPUT], perf_timing != 0);
 			// Headset tracking data:
 			{
 				t_symbol * id = ps_head;
 				
 				// raw tracking data
-				const ovrPosef& pose = ts.HeadPose.ThePose;
-
-				glm::mat4 mat = glm::translate(glm::mat4(1.0f), to_glm(pose.Position))
-					* mat4_cast(to_glm(pose.Orientation));
-				glm::vec3 p = glm::vec3(mat[3]); // the translation component
-				glm::quat q = glm::quat_cast(mat); // the orientation component
-
-				// adjusted to world space
-				glm::mat4 world_mat = view_mat * mat;
-				glm::vec3 p1 = glm::vec3(world_mat[3]); // the translation component
-				glm::quat q1 = glm::quat_cast(world_mat); // the orientation component
-
-				atom_setsym(a + 0, ps_tracked_position);
-				atom_setfloat(a + 1, p.x);
-				atom_setfloat(a + 2, p.y);
-				atom_setfloat(a + 3, p.z);
-				outlet_anything(outlet_tracking, id, 4, a);
-
-				atom_setsym(a + 0, ps_tracked_quat);
-				atom_setfloat(a + 1, q.x);
-				atom_setfloat(a + 2, q.y);
-				atom_setfloat(a + 3, q.z);
-				atom_setfloat(a + 4, q.w);
-				outlet_anything(outlet_tracking, id, 5, a);
-
-				atom_setsym(a + 0, _jit_sym_position);
-				atom_setfloat(a + 1, p1.x);
-				atom_setfloat(a + 2, p1.y);
-				atom_setfloat(a + 3, p1.z);
-				outlet_anything(outlet_tracking, id, 4, a);
-
-				atom_setsym(a + 0, _jit_sym_quat);
-				atom_setfloat(a + 1, q1.x);
-				atom_setfloat(a + 2, q1.y);
-				atom_setfloat(a + 3, q1.z);
-				atom_setfloat(a + 4, q1.w);
-				outlet_anything(outlet_tracking, id, 5, a);
+				head_pose = to_pose(ts.HeadPose.ThePose);
+				filter_pose(id, 0, head_pose, to_glm(ts.HeadPose.LinearVelocity), to_glm(ts.HeadPose.AngularVelocity));
+				output_tracked_pose(id, 0, head_pose);
+				// head velocities are only captured in the row (matrix or recording), not sent as messages:
+				output_tracked_velocity(id, 0, to_glm(ts.HeadPose.LinearVelocity), to_glm(ts.HeadPose.AngularVelocity), false);
 			}
 
 			// controllers:
@@ -1282,64 +3068,44 @@ struct Vr {
 				for (int i = 0; i < 2; i++) {
 
 					t_symbol * id = i ? ps_right_hand : ps_left_hand;
+					int index = i + 1; // row in the tracking matrix
 
-					const ovrPosef& pose = ts.HandPoses[i].ThePose;
-
-					glm::mat4 mat = glm::translate(glm::mat4(1.0f), to_glm(pose.Position))
-						* mat4_cast(to_glm(pose.Orientation));
-					glm::vec3 p = glm::vec3(mat[3]); // the translation component
-					glm::quat q = glm::quat_cast(mat); // the orientation component
-					
-					// adjusted to world space
-					glm::mat4 world_mat = view_mat * mat;
-					glm::vec3 p1 = glm::vec3(world_mat[3]); // the translation component
-					glm::quat q1 = glm::quat_cast(world_mat); // the orientation component
-
-					atom_setsym(a + 0, ps_tracked_position);
-					atom_setfloat(a + 1, p.x);
-					atom_setfloat(a + 2, p.y);
-					atom_setfloat(a + 3, p.z);
-					outlet_anything(outlet_tracking, id, 4, a);
-
-					atom_setsym(a + 0, ps_tracked_quat);
-					atom_setfloat(a + 1, q.x);
-					atom_setfloat(a + 2, q.y);
-					atom_setfloat(a + 3, q.z);
-					atom_setfloat(a + 4, q.w);
-					outlet_anything(outlet_tracking, id, 5, a);
-
-					atom_setsym(a + 0, _jit_sym_position);
-					atom_setfloat(a + 1, p1.x);
-					atom_setfloat(a + 2, p1.y);
-					atom_setfloat(a + 3, p1.z);
-					outlet_anything(outlet_tracking, id, 4, a);
-
-					atom_setsym(a + 0, _jit_sym_quat);
-					atom_setfloat(a + 1, q1.x);
-					atom_setfloat(a + 2, q1.y);
-					atom_setfloat(a + 3, q1.z);
-					atom_setfloat(a + 4, q1.w);
-					outlet_anything(outlet_tracking, id, 5, a);
+					Pose pose = to_pose(ts.HandPoses[i].ThePose);
+					filter_pose(id, index, pose, to_glm(ts.HandPoses[i].LinearVelocity), to_glm(ts.HandPoses[i].AngularVelocity));
+					output_tracked_pose(id, index, pose);
 
 					// velocities:
 					// note that these are in tracking space
-					glm::vec3 vel = to_glm(ts.HandPoses[i].LinearVelocity);
-					glm::vec3 angvel = to_glm(ts.HandPoses[i].AngularVelocity);
-					// rotated into world space (TODO is this appropriate? rotate or unrotate?)
-					vel = quat_rotate(view_quat, vel);
-					angvel = quat_rotate(view_quat, angvel);
-
-					atom_setsym(a + 0, ps_velocity);
-					atom_setfloat(a + 1, vel.x);
-					atom_setfloat(a + 2, vel.y);
-					atom_setfloat(a + 3, vel.z);
-					outlet_anything(outlet_tracking, id, 4, a);
-
-					atom_setsym(a + 0, ps_angular_velocity);
-					atom_setfloat(a + 1, angvel.x);
-					atom_setfloat(a + 2, angvel.y);
-					atom_setfloat(a + 3, angvel.z);
-					outlet_anything(outlet_tracking, id, 4, a);
+					output_tracked_velocity(id, index, to_glm(ts.HandPoses[i].LinearVelocity), to_glm(ts.HandPoses[i].AngularVelocity));
+
+					if (uint32_t * in = record_input(index)) {
+						// the button masks cover both hands; the axes are this hand's
+						const float axes[SESSION_INPUT_WORDS - SESSION_INPUT_AXES] = {
+							inputState.Thumbstick[i].x, inputState.Thumbstick[i].y,
+							inputState.IndexTrigger[i], inputState.HandTrigger[i],
+							inputState.ThumbstickNoDeadzone[i].x, inputState.ThumbstickNoDeadzone[i].y,
+							inputState.IndexTriggerNoDeadzone[i], inputState.HandTriggerNoDeadzone[i],
+							inputState.ThumbstickRaw[i].x, inputState.ThumbstickRaw[i].y,
+							inputState.IndexTriggerRaw[i], inputState.HandTriggerRaw[i]
+						};
+						in[SESSION_INPUT_PRESSED] = inputState.Buttons;
+						in[SESSION_INPUT_TOUCHED] = inputState.Touches;
+						for (int k = 0; k < SESSION_INPUT_WORDS - SESSION_INPUT_AXES; k++) in[SESSION_INPUT_AXES + k] = SessionCodec::float_bits(axes[k]);
+					}
+
+					if (float * row = tracking_row(index, id)) {
+						row[TRACKING_TRIGGER + 0] = inputState.IndexTrigger[i] > 0.25;
+						row[TRACKING_TRIGGER + 1] = inputState.IndexTrigger[i];
+						row[TRACKING_HAND_TRIGGER + 0] = inputState.HandTrigger[i] > 0.25;
+						row[TRACKING_HAND_TRIGGER + 1] = inputState.HandTrigger[i];
+						row[TRACKING_PAD + 0] = (inputState.Touches & (i ? ovrButton_RThumb : ovrButton_LThumb)) != 0;
+						row[TRACKING_PAD + 1] = inputState.Thumbstick[i].x;
+						row[TRACKING_PAD + 2] = inputState.Thumbstick[i].y;
+						row[TRACKING_PAD + 3] = (inputState.Buttons & (i ? ovrButton_RThumb : ovrButton_LThumb)) != 0;
+						row[TRACKING_BUTTONS + 0] = (inputState.Buttons & (i ? ovrButton_A : ovrButton_X)) != 0;
+						row[TRACKING_BUTTONS + 1] = (inputState.Buttons & (i ? ovrButton_B : ovrButton_Y)) != 0;
+					}
+					if (!tracking_messages) continue;
 
 					// buttons
 					atom_setsym(a + 0, ps_trigger);
@@ -1366,6 +3132,47 @@ struct Vr {
 				}
 			}
 		}
+
+		oculus_output_chain_texture();
+	}
+
+	// the eye poses (and the layer's) predicted again, for latch()
+	// the latched head goes through @filter as a new sample, at the latch time; the eye poses are not filtered
+	bool oculus_latch() {
+		if (!oculus.session) return false;
+		double displayMidpointSeconds = ovr_GetPredictedDisplayTime(oculus.session, oculus.frameIndex);
+		ovrTrackingState ts = ovr_GetTrackingState(oculus.session, displayMidpointSeconds, ovrTrue);
+		double sampleTime = ovr_GetTimeInSeconds();
+		if (!(ts.StatusFlags & (ovrStatus_OrientationTracked | ovrStatus_PositionTracked))) return false;
+		ovr_CalcEyePoses(ts.HeadPose.ThePose, oculus.hmdToEyeViewOffset, oculus.layer.RenderPose);
+		oculus.sensorSampleTime = sampleTime;
+		oculus.layer.SensorSampleTime = sampleTime;
+		head_pose = to_pose(ts.HeadPose.ThePose);
+		// the latched head is a new sample for the head's filter (if any), as in oculus_bang():
+		filter_pose(ps_head, 0, head_pose, to_glm(ts.HeadPose.LinearVelocity), to_glm(ts.HeadPose.AngularVelocity), PoseChannel::now());
+		for (int eye = 0; eye < 2; eye++) {
+			eye_pose[eye] = to_pose(oculus.layer.RenderPose[eye]);
+		}
+		return true;
+	}
+
+	// runs in the poll thread
+	void oculus_poll(double t) {
+		if (!oculus.session) return;
+		// absolute time 0 means "now" (no prediction):
+		ovrTrackingState ts = ovr_GetTrackingState(oculus.session, 0., ovrFalse);
+		const ovrPoseStatef * states[3] = { &ts.HeadPose, &ts.HandPoses[0], &ts.HandPoses[1] };
+		for (int i = 0; i < 3; i++) {
+			if (i == 0 && !(ts.StatusFlags & (ovrStatus_OrientationTracked | ovrStatus_PositionTracked))) continue;
+			if (i > 0 && !(ts.HandStatusFlags[i - 1] & (ovrStatus_OrientationTracked | ovrStatus_PositionTracked))) continue;
+			PoseSample s;
+			s.time = t;
+			s.quat = to_glm(states[i]->ThePose.Orientation);
+			s.position = to_glm(states[i]->ThePose.Position);
+			s.velocity = to_glm(states[i]->LinearVelocity);
+			s.angular_velocity = to_glm(states[i]->AngularVelocity);
+			poll_rings[i].write(s);
+		}
 	}
 
 	GLuint oculus_get_texid() {
@@ -1385,34 +3192,175 @@ struct Vr {
 		return true;
 	}
 
-	bool oculus_submit_texture_gl3(t_symbol *intexture) {
+	// the copy goes into the persistent wrapper of the current chain buffer (see oculus_create_chain_textures),
+	// rather than re-pointing one texture's glid at each buffer in turn
+	bool oculus_submit_texture_gl3(t_symbol *intexture, GLuint input_texture_id) {
 		if (oculus_texture_ready()) {
-			object_attr_setlong(gl3_texture, ps_glid, oculus_get_texid());
-			gl3_copy_texture(intexture);
+			int curIndex = 0;
+			ovr_GetTextureSwapChainCurrentIndex(oculus.session, oculus.textureChain, &curIndex);
+			oculus_set_viewports(fbo_dim);
+			if (curIndex >= 0 && curIndex < oculus.chainLength) {
+				if (input_texture_id == oculus.chainIds[curIndex]) {
+					set_submit_path(ps_direct);
+					oculus_set_origin(true);
+					return oculus_commit_texture();
+				}
+				set_submit_path(ps_gl3_copy);
+				oculus_set_origin(false);
+				gl3_copy_texture(oculus.chainTextures[curIndex], intexture);
+				return oculus_commit_texture();
+			}
+			// the chain couldn't be wrapped:
+			GLuint texid = oculus_get_texid();
+			if (input_texture_id == texid) {
+				set_submit_path(ps_direct);
+				oculus_set_origin(true);
+				return oculus_commit_texture();
+			}
+			set_submit_path(ps_gl3_copy);
+			oculus_set_origin(false);
+			object_attr_setlong(gl3_texture, ps_glid, texid);
+			gl3_copy_texture(gl3_texture, intexture);
 			return oculus_commit_texture();
 		}
 		return false;
 	}
 
 	bool oculus_submit_texture(GLuint input_texture_id, t_atom_long input_texture_dim[2]) {
-		if (!oculus_texture_ready() || !fbo_copy_texture(input_texture_id, input_texture_dim,
-			fbo_id, oculus_get_texid(), fbo_dim, true)) {
+		if (!oculus_texture_ready()) return false;
+		// already rendered into the current chain buffer? then there's nothing to copy
+		if (input_texture_id == oculus_get_texid()) {
+			set_submit_path(ps_direct);
+			oculus_set_origin(true);
+			oculus_set_viewports(fbo_dim);
+			return oculus_commit_texture();
+		}
+		set_submit_path(ps_copy);
+		oculus_set_origin(false);
+		oculus_set_viewports(render_dim);
+		bool copied;
+		{
+			PerfScope perf_scope(perf_stages[PERF_COPY], perf_timing != 0);
+			copied = fbo_copy_texture(input_texture_id, input_texture_dim, fbo_id, oculus_get_texid(), render_dim, true);
+		}
+		if (!copied) {
 			object_error(&ob, "problem copying texture");
 			return false;
 		}
 		return oculus_commit_texture();
 	}
 
+	// a vr.layer as a quad layer, with its own swap chain
+	// returns whether the layer can be submitted; copied is set if the content was copied this frame
+	bool oculus_layer_update(int i, Layer * layer, GLuint glid, GLenum target, t_atom_long dim[2], bool due, Pose const & pose, float height, bool & copied) {
+		LayerState & state = layer_states[i];
+		if (!oculus.session) return false;
+
+		// a StaticImage chain can only be committed once, so new static content needs a new chain
+		bool resized = dim[0] != state.dim[0] || dim[1] != state.dim[1];
+		if (state.chain && (resized || (due && (layer->is_static || state.is_static)))) {
+			ovr_DestroyTextureSwapChain(oculus.session, state.chain);
+			state.chain = 0;
+			state.chain_committed = false;
+		}
+		if (!state.chain) {
+			ovrTextureSwapChainDesc desc = {};
+			desc.Type = ovrTexture_2D;
+			desc.ArraySize = 1;
+			desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+			desc.Width = int(dim[0]);
+			desc.Height = int(dim[1]);
+			desc.MipLevels = 1;
+			desc.SampleCount = 1;
+			desc.StaticImage = layer->is_static ? ovrTrue : ovrFalse;
+			if (!OVR_SUCCESS(ovr_CreateTextureSwapChainGL(oculus.session, &desc, &state.chain))) {
+				ovrErrorInfo errInfo;
+				ovr_GetLastErrorInfo(&errInfo);
+				object_error(&ob, "failed to create layer texture set: %s", errInfo.ErrorString);
+				state.chain = 0;
+				return false;
+			}
+			state.dim[0] = dim[0];
+			state.dim[1] = dim[1];
+			due = true;
+		}
+
+		if (due) {
+			int index = 0;
+			GLuint texid = 0;
+			ovr_GetTextureSwapChainCurrentIndex(oculus.session, state.chain, &index);
+			ovr_GetTextureSwapChainBufferGL(oculus.session, state.chain, index, &texid);
+			if (!fbo_copy_texture(glid, dim, layer_fbo_id, texid, dim, true, target)) {
+				object_error(&ob, "problem copying layer texture");
+				return false;
+			}
+			if (!OVR_SUCCESS(ovr_CommitTextureSwapChain(oculus.session, state.chain))) {
+				object_error(&ob, "problem committing layer texture chain");
+				return false;
+			}
+			state.chain_committed = true;
+			copied = true;
+		}
+
+		ovrLayerQuad & quad = state.quad;
+		quad.Header.Type = ovrLayerType_Quad;
+		quad.Header.Flags = layer->head_locked ? ovrLayerFlag_HeadLocked : 0;
+		quad.ColorTexture = state.chain;
+		quad.Viewport.Pos.x = 0;
+		quad.Viewport.Pos.y = 0;
+		quad.Viewport.Size.w = int(dim[0]);
+		quad.Viewport.Size.h = int(dim[1]);
+		quad.QuadPoseCenter = to_ovr(pose);
+		quad.QuadSize.x = layer->width;
+		quad.QuadSize.y = height;
+		return state.chain_committed;
+	}
+
+	// the copies (fbo_copy_texture with flipY, and the gl3 copy) turn the rows top-down into the chain buffer,
+	// but a frame rendered straight into the chain has GL's bottom-up rows
+	void oculus_set_origin(bool bottom_left) {
+		oculus.layer.Header.Flags = bottom_left ? ovrLayerFlag_TextureOriginAtBottomLeft : 0;
+	}
+
+	// the layer reads the left & right halves of this region at the top-left of the swap chain texture
+	void oculus_set_viewports(t_atom_long dim[2]) {
+		int half = int(dim[0] / 2);
+		oculus.layer.Viewport[0].Pos.x = 0;
+		oculus.layer.Viewport[0].Pos.y = 0;
+		oculus.layer.Viewport[0].Size.w = half;
+		oculus.layer.Viewport[0].Size.h = int(dim[1]);
+		oculus.layer.Viewport[1].Pos.x = half;
+		oculus.layer.Viewport[1].Pos.y = 0;
+		oculus.layer.Viewport[1].Size.w = int(dim[0]) - half;
+		oculus.layer.Viewport[1].Size.h = int(dim[1]);
+	}
+
 	bool oculus_commit_texture() {
 		// and commit it
-		if (!OVR_SUCCESS(ovr_CommitTextureSwapChain(oculus.session, oculus.textureChain))) {
-			object_error(&ob, "problem committing texture chain");
+		{
+			PerfScope perf_scope(perf_stages[PERF_COMMIT], perf_timing != 0);
+			if (!OVR_SUCCESS(ovr_CommitTextureSwapChain(oculus.session, oculus.textureChain))) {
+				object_error(&ob, "problem committing texture chain");
+			}
 		}
 
-		// Submit frame with one layer we have.
+		// Submit frame with the scene layer, and the quad layers of any vr.layer objects on top.
 		// ovr_SubmitFrame returns once frame present is queued up and the next texture slot in the ovrSwatextureChain is available for the next frame. 
-		ovrLayerHeader* layers = &oculus.layer.Header;
-		ovrResult       result = ovr_SubmitFrame(oculus.session, oculus.frameIndex, nullptr, &layers, 1);
+		if (submit_async && oculus_push_frame()) {
+			oculus.frameIndex++;
+			return true;
+		}
+		ovrLayerHeader* layers[1 + VR_MAX_LAYERS];
+		int numlayers = 0;
+		layers[numlayers++] = &oculus.layer.Header;
+		for (int i = 0; i < VR_MAX_LAYERS; i++) {
+			if (layer_states[i].visible) layers[numlayers++] = &layer_states[i].quad.Header;
+		}
+		ovrResult       result;
+		{
+			PerfScope perf_scope(perf_stages[PERF_SUBMIT], perf_timing != 0);
+			result = ovr_SubmitFrame(oculus.session, oculus.frameIndex, nullptr, layers, numlayers);
+		}
 		if (result == ovrError_DisplayLost) {
 			/*
 			TODO: If you receive ovrError_DisplayLost, the device was removed and the session is invalid.
@@ -1433,6 +3381,30 @@ struct Vr {
 			return true;
 		}
 	}
+
+	// queue the committed frame for the submit thread, with a copy of its layers
+	bool oculus_push_frame() {
+		SubmitJob job;
+		job.driver = ps_oculus;
+		job.frameIndex = oculus.frameIndex;
+		job.eye = oculus.layer;
+		job.numquads = 0;
+		for (int i = 0; i < VR_MAX_LAYERS; i++) {
+			if (layer_states[i].visible) job.quads[job.numquads++] = layer_states[i].quad;
+		}
+		return submit_async_push(job);
+	}
+
+	// runs in the submit thread
+	void oculus_submit_job(SubmitJob& job) {
+		ovrLayerHeader* layers[1 + VR_MAX_LAYERS];
+		int numlayers = 0;
+		layers[numlayers++] = &job.eye.Header;
+		for (int i = 0; i < job.numquads; i++) layers[numlayers++] = &job.quads[i].Header;
+		if (ovr_SubmitFrame(oculus.session, job.frameIndex, nullptr, layers, numlayers) == ovrError_DisplayLost) {
+			submit_lost = 1;
+		}
+	}
 	
 #endif
 
@@ -1452,7 +3424,7 @@ struct Vr {
 		return sResult;
 	}
 
-	bool steam_is_available() {
+	static bool steam_is_available() {
 		return (vr::VR_IsRuntimeInstalled() && vr::VR_IsHmdPresent());
 	}
 
@@ -1481,6 +3453,7 @@ struct Vr {
 		VR_DEBUG_POST("steam connected");
 
 		driver = ps_steam;
+		steam_devices_rebuild();
 		return true;
 	}
 
@@ -1496,6 +3469,7 @@ struct Vr {
 			//vr::VR_Shutdown();
 
 			steam.hmd = 0;
+			steam.numlive = 0;
 		}
 	}
 
@@ -1520,11 +3494,89 @@ struct Vr {
 		fbo_dim[0] = dim[0] * 2; // side-by-side
 		fbo_dim[1] = dim[1];
 
+		float rate = steam.hmd->GetFloatTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_DisplayFrequency_Float);
+		if (rate > 0.f) steam.refresh_rate = rate;
+
 		// maybe never: support disabling tracking options via ovr_ConfigureTracking()
 
 		VR_DEBUG_POST("steam configured");
 	}
 
+	// (re)query the cached properties of a device slot, 
+	// and add/remove it from the live list accordingly
+	void steam_device_update(vr::TrackedDeviceIndex_t i) {
+		if (!steam.hmd || i >= vr::k_unMaxTrackedDeviceCount) return;
+		auto& dev = steam.devices[i];
+		
+		if (steam.hmd->IsTrackedDeviceConnected(i)) {
+			dev.cls = steam.hmd->GetTrackedDeviceClass(i);
+			dev.role = steam.hmd->GetControllerRoleForTrackedDeviceIndex(i);
+			dev.serial = steam_get_tracked_device_name(steam.hmd, i, vr::Prop_SerialNumber_String);
+			switch (dev.cls) {
+			case vr::TrackedDeviceClass_HMD: dev.id = ps_head; break;
+			case vr::TrackedDeviceClass_Controller: {
+				switch (dev.role) {
+				case vr::TrackedControllerRole_LeftHand: dev.id = ps_left_hand; break;
+				case vr::TrackedControllerRole_RightHand: dev.id = ps_right_hand; break;
+				default: dev.id = 0; break; // not output
+				}
+			} break;
+			case vr::TrackedDeviceClass_GenericTracker: 
+				dev.id = (dev.serial != _jit_sym_nothing) ? dev.serial : ps_generic; 
+				break;
+			default: dev.id = 0; break; // not output
+			}
+			if (!dev.live) {
+				steam.live[steam.numlive++] = i;
+				dev.live = steam.numlive;
+			}
+		}
+		else {
+			if (dev.live) {
+				// swap the last live device into this position:
+				vr::TrackedDeviceIndex_t last = steam.live[--steam.numlive];
+				steam.live[dev.live - 1] = last;
+				steam.devices[last].live = dev.live;
+			}
+			dev = SteamDevice();
+		}
+
+		// keep the hand lookup (used by haptics) in sync:
+		for (int hand = 0; hand < 2; hand++) {
+			if (steam.mHandControllerDeviceIndex[hand] == (int)i) steam.mHandControllerDeviceIndex[hand] = -1;
+		}
+		if (dev.cls == vr::TrackedDeviceClass_Controller) {
+			if (dev.role == vr::TrackedControllerRole_LeftHand) steam.mHandControllerDeviceIndex[0] = i;
+			else if (dev.role == vr::TrackedControllerRole_RightHand) steam.mHandControllerDeviceIndex[1] = i;
+		}
+	}
+
+	void steam_devices_rebuild() {
+		steam.numlive = 0;
+		for (int hand = 0; hand < 2; hand++) steam.mHandControllerDeviceIndex[hand] = -1;
+		for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+			steam.devices[i] = SteamDevice();
+			steam_device_update(i);
+		}
+	}
+
+	// the driver's hidden & visible area meshes of both eyes, side by side
+	void steam_area_meshes() {
+		if (!steam.hmd) return;
+		for (int eye = 0; eye < 2; eye++) {
+			for (int which = AREA_HIDDEN; which <= AREA_VISIBLE; which++) {
+				vr::HiddenAreaMesh_t mesh = steam.hmd->GetHiddenAreaMesh(eye ? vr::Eye_Right : vr::Eye_Left, 
+					which == AREA_HIDDEN ? vr::k_eHiddenAreaMesh_Standard : vr::k_eHiddenAreaMesh_Inverse);
+				if (!mesh.pVertexData) continue;
+				// (u, v) per eye, as in VRTextureBounds_t:
+				for (uint32_t i = 0; i < mesh.unTriangleCount * 3; i++) {
+					const vr::HmdVector2_t& v = mesh.pVertexData[i];
+					area_mesh[which].push_back(glm::vec2(0.5f * (eye + v.v[0]), v.v[1]));
+				}
+			}
+		}
+	}
+
 	// call at maximum frequency of 5ms
 	void steam_haptic(unsigned int hand = 0, float intensity = 0.5f) {
 		if (!steam.hmd) return;
@@ -1537,42 +3589,16 @@ struct Vr {
 
 	void steam_battery() {
 		if (!steam.hmd) return;
-		// check each device slot:
+		// check each active device:
 		t_atom a[2];
-		for (int i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
-			const vr::TrackedDevicePose_t& trackedDevicePose = steam.pRenderPoseArray[i];
-			// if the device is actually connected:
-			if (trackedDevicePose.bDeviceIsConnected) {
-
-				switch (steam.hmd->GetTrackedDeviceClass(i)) {
-				case vr::TrackedDeviceClass_Controller: {
-					// check role to see if these are hands
-					vr::ETrackedControllerRole role = steam.hmd->GetControllerRoleForTrackedDeviceIndex(i);
-					switch (role) {
-					case vr::TrackedControllerRole_LeftHand:
-					case vr::TrackedControllerRole_RightHand: 
-						t_symbol * id = (role == vr::TrackedControllerRole_RightHand) ? ps_right_hand : ps_left_hand;
-						atom_setsym(a + 0, id);
-						atom_setfloat(a + 1, steam.hmd->GetFloatTrackedDeviceProperty(i, vr::Prop_DeviceBatteryPercentage_Float));
-						outlet_anything(outlet_msg, gensym("battery"), 2, a);
-
-					}
-				} break;
-				case vr::TrackedDeviceClass_GenericTracker:
-				{
-					t_symbol * id = ps_generic;
-					vr::ETrackedPropertyError err = vr::TrackedProp_Success;
-					char buf[vr::k_unMaxPropertyStringSize];
-					if (vr::VRSystem()->GetStringTrackedDeviceProperty(i, vr::Prop_SerialNumber_String, buf, sizeof(buf), &err)) {
-						id = gensym(buf);
-					}
-					atom_setsym(a + 0, id);
-					atom_setfloat(a + 1, steam.hmd->GetFloatTrackedDeviceProperty(i, vr::Prop_DeviceBatteryPercentage_Float));
-					outlet_anything(outlet_msg, gensym("battery"), 2, a);
-				} break;
-				default:
-					break;
-				}
+		for (int j = 0; j < steam.numlive; j++) {
+			const vr::TrackedDeviceIndex_t i = steam.live[j];
+			const SteamDevice& dev = steam.devices[i];
+			// hands & trackers only:
+			if (dev.id && dev.cls != vr::TrackedDeviceClass_HMD) {
+				atom_setsym(a + 0, dev.id);
+				atom_setfloat(a + 1, steam.hmd->GetFloatTrackedDeviceProperty(i, vr::Prop_DeviceBatteryPercentage_Float));
+				outlet_anything(outlet_msg, gensym("battery"), 2, a);
 			}
 		}
 	}
@@ -1582,7 +3608,8 @@ struct Vr {
 		VR_DEBUG_POST("steam_create_gpu_resources");
 		if (!steam.hmd) return false;
 
-		glGenTextures(1, &steam.fbo_texture_id);
+		glGenTextures(STEAM_SUBMIT_TEXTURES, steam.submit_textures);
+		steam.fbo_texture_id = steam.submit_textures[0];
 		glGenRenderbuffersEXT(1, &rbo_id);
 
 		VR_DEBUG_POST("fbo %d rbo %d tex %d", fbo_id, rbo_id, steam.fbo_texture_id);
@@ -1591,10 +3618,15 @@ struct Vr {
 		glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &previousFBO);
 		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo_id);
 		{
-			glBindTexture(GL_TEXTURE_2D, steam.fbo_texture_id);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, fbo_dim[0], fbo_dim[1], 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+			for (int i = 0; i < STEAM_SUBMIT_TEXTURES; i++) {
+				glBindTexture(GL_TEXTURE_2D, steam.submit_textures[i]);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, fbo_dim[0], fbo_dim[1], 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+				steam.submit_frames[i] = 0;
+				steam.submit_pending[i] = 0;
+			}
+			glBindTexture(GL_TEXTURE_2D, 0);
 			glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, steam.fbo_texture_id, 0);
 			// TODO: is rbo actually necessary?
 			glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, rbo_id);
@@ -1619,11 +3651,52 @@ struct Vr {
 		return true;
 	}
 
+	// the SteamVR mirror is undistorted, with one texture per eye
+	// it is not locked (LockGLSharedTextureForAccess) while the patch reads it, so it may occasionally tear
+	void steam_mirror_create() {
+		if (!steam.hmd || !vr::VRCompositor()) return;
+		std::lock_guard<std::mutex> lock(compositor_mutex);
+		if (mirror == ps_distorted) {
+			object_warn(&ob, "SteamVR only mirrors undistorted eyes; using @mirror both");
+		}
+		for (int eye = 0; eye < 2; eye++) {
+			if ((mirror == ps_left && eye == 1) || (mirror == ps_right && eye == 0)) continue;
+			vr::EVRCompositorError err = vr::VRCompositor()->GetMirrorTextureGL(eye ? vr::Eye_Right : vr::Eye_Left, 
+				&steam.mirror_ids[eye], &steam.mirror_handles[eye]);
+			if (err != vr::VRCompositorError_None) {
+				object_error(&ob, "failed to get mirror texture (error %d)", (int)err);
+				steam.mirror_ids[eye] = 0;
+				steam.mirror_handles[eye] = 0;
+				continue;
+			}
+			mirror_add(steam.mirror_ids[eye]);
+		}
+	}
+
+	void steam_mirror_release() {
+		std::lock_guard<std::mutex> lock(compositor_mutex);
+		for (int eye = 0; eye < 2; eye++) {
+			if (steam.mirror_handles[eye] && vr::VRCompositor()) {
+				vr::VRCompositor()->ReleaseSharedGLTexture(steam.mirror_ids[eye], steam.mirror_handles[eye]);
+			}
+			steam.mirror_ids[eye] = 0;
+			steam.mirror_handles[eye] = 0;
+		}
+	}
+
 	void steam_release_gpu_resources() {
-		if (steam.fbo_texture_id) {
-			glDeleteTextures(1, &steam.fbo_texture_id);
-			steam.fbo_texture_id = 0;
+		for (int i = 0; i < STEAM_SUBMIT_TEXTURES; i++) {
+			if (steam.submit_fences[i]) {
+				glDeleteSync(steam.submit_fences[i]);
+				steam.submit_fences[i] = 0;
+			}
+			if (steam.submit_textures[i]) {
+				glDeleteTextures(1, &steam.submit_textures[i]);
+				steam.submit_textures[i] = 0;
+			}
 		}
+		steam.fbo_texture_id = 0;
+		steam.submit_current = -1;
 
 		if (rbo_id) {
 			glDeleteRenderbuffersEXT(1, &rbo_id);
@@ -1636,13 +3709,19 @@ struct Vr {
 	void steam_bang() {
 		if (!steam.hmd) return;
 
+		// each WaitGetPoses must follow the Submit of the frame before,
+		// so a frame still with the submit thread has to be submitted first
+		submit_async_drain();
+
 		t_atom a[6];
 
 		vr::VREvent_t event;
 		while (steam.hmd->PollNextEvent(&event, sizeof(event))) {
+			if (recording()) record_event(event.eventType, event.trackedDeviceIndex, event.eventAgeSeconds, &event.data, sizeof(event.data));
 			switch (event.eventType) {
 				case vr::VREvent_TrackedDeviceActivated:
 				{
+					steam_device_update(event.trackedDeviceIndex);
 					atom_setlong(&a[0], event.trackedDeviceIndex);
 					outlet_anything(outlet_msg, gensym("attached"), 1, a);
 					//setupRenderModelForTrackedDevice(event.trackedDeviceIndex);
@@ -1650,11 +3729,24 @@ struct Vr {
 				break;
 				case vr::VREvent_TrackedDeviceDeactivated:
 				{
+					steam_device_update(event.trackedDeviceIndex);
 					atom_setlong(&a[0], event.trackedDeviceIndex);
 					outlet_anything(outlet_msg, gensym("detached"), 1, a);
 				}
 				break;
-				//case vr::VREvent_TrackedDeviceUpdated: break;
+				case vr::VREvent_TrackedDeviceUpdated:
+				{
+					steam_device_update(event.trackedDeviceIndex);
+				}
+				break;
+				case vr::VREvent_TrackedDeviceRoleChanged:
+				{
+					// roles may have been swapped between devices, so refresh all live devices:
+					for (int j = steam.numlive - 1; j >= 0; j--) {
+						steam_device_update(steam.live[j]);
+					}
+				}
+				break;
 				default: {
 					// TODO: lots of interesting events in openvr.h
 					// 
@@ -1674,76 +3766,80 @@ struct Vr {
 
 			//VR_DEBUG_POST("frustum l %f r %f t %f b %f", l, r, t, b);
 
-			atom_setfloat(a + 0, l * near_clip);
-			atom_setfloat(a + 1, r * near_clip);
-			atom_setfloat(a + 2, -b * near_clip);
-			atom_setfloat(a + 3, -t * near_clip);
-			atom_setfloat(a + 4, near_clip);
-			atom_setfloat(a + 5, far_clip);
-			outlet_anything(outlet_eye[i], ps_frustum, 6, a);
+			output_frustum(i, l * near_clip, r * near_clip, -b * near_clip, -t * near_clip);
+		}
+
+		// get the tracking data here
+		vr::EVRCompositorError err;
+		{
+			PerfScope perf_scope(perf_stages[PERF_WAIT], perf_timing != 0);
+			std::lock_guard<std::mutex> lock(compositor_mutex);
+			err = vr::VRCompositor()->WaitGetPoses(steam.pRenderPoseArray, vr::k_unMaxTrackedDeviceCount, NULL, 0);
 		}
-
-		// get the tracking data here
-		vr::EVRCompositorError err = vr::VRCompositor()->WaitGetPoses(steam.pRenderPoseArray, vr::k_unMaxTrackedDeviceCount, NULL, 0);
 		if (err != vr::VRCompositorError_None) {
 			object_error(&ob, "WaitGetPoses error");
 			return;
 		}
 
+		// convert all device poses & velocities, and move them into world space, in one pass:
+		// (only the slots the SDK has devices for; the batches have room for more)
+		const size_t stride = sizeof(vr::TrackedDevicePose_t);
+		const int count = vr::k_unMaxTrackedDeviceCount;
+		steam.poses.from_mat34(&steam.pRenderPoseArray[0].mDeviceToAbsoluteTracking, stride, count);
+		steam.world_poses = steam.poses;
+		steam.world_poses.premultiply(view_pose, count);
+		// TODO: check if these are in tracking space
+		steam.world_velocities.gather(&steam.pRenderPoseArray[0].vVelocity, stride, count);
+		steam.world_velocities.rotate(view_pose.quat, count);
+		steam.world_angular_velocities.gather(&steam.pRenderPoseArray[0].vAngularVelocity, stride, count);
+		steam.world_angular_velocities.rotate(view_pose.quat, count);
+
 		// TODO: should we ignore button presses etc. if so?
 		bool inputCapturedByAnotherProcess = steam.hmd->IsInputFocusCapturedByAnotherProcess();
 
-		// check each device slot:
-		for (int i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+		// check each active device:
+		PerfScope perf_scope(perf_stages[PERF_OUTPUT], perf_timing != 0);
+		for (int j = 0; j < steam.numlive; j++) {
+			const vr::TrackedDeviceIndex_t i = steam.live[j];
+			const SteamDevice& dev = steam.devices[i];
 			const vr::TrackedDevicePose_t& trackedDevicePose = steam.pRenderPoseArray[i];
 			// if the device is actually connected:
-			if (trackedDevicePose.bDeviceIsConnected) {
+			if (trackedDevicePose.bDeviceIsConnected && dev.id) {
 				
-				switch (steam.hmd->GetTrackedDeviceClass(i)) {
+				switch (dev.cls) {
 				case vr::TrackedDeviceClass_HMD: {
 					if (trackedDevicePose.bPoseIsValid) {
-						t_symbol * id = ps_head;
+						t_symbol * id = dev.id;
 
-						glm::mat4 mat = steam_output_tracked_device(id, trackedDevicePose);
+						head_pose = steam_output_tracked_device(id, i);
 
 						// use this to update cameras:
 						for (int i = 0; i < 2; i++) {
 
-							steam.head2eye_mat[i] = to_glm(steam.hmd->GetEyeToHeadTransform((vr::Hmd_Eye)i));
-							eye_mat[i] = mat * steam.head2eye_mat[i];
+							steam.head2eye[i] = to_pose(steam.hmd->GetEyeToHeadTransform((vr::Hmd_Eye)i));
+							eye_pose[i] = head_pose * steam.head2eye[i];
 							
 							float l, r, t, b;
 							steam.hmd->GetProjectionRaw((vr::Hmd_Eye)i, &l, &r, &t, &b);
-							atom_setfloat(a + 0, l * near_clip);
-							atom_setfloat(a + 1, r * near_clip);
-							// TODO: check if this is right for Vive?
-							//atom_setfloat(a + 2, -b * near_clip);
-							//atom_setfloat(a + 3, -t * near_clip);
-							atom_setfloat(a + 2, t * near_clip);
-							atom_setfloat(a + 3, b * near_clip);
-							atom_setfloat(a + 4, near_clip);
-							atom_setfloat(a + 5, far_clip);
-							outlet_anything(outlet_eye[i], ps_frustum, 6, a);
+							// TODO: check if this is right for Vive? (was -b, -t)
+							output_frustum(i, l * near_clip, r * near_clip, t * near_clip, b * near_clip);
 						}
 
 					}
 				} break;
 				case vr::TrackedDeviceClass_Controller: {
 					// check role to see if these are hands
-					vr::ETrackedControllerRole role = steam.hmd->GetControllerRoleForTrackedDeviceIndex(i);
+					vr::ETrackedControllerRole role = dev.role;
 					switch (role) {
 					case vr::TrackedControllerRole_LeftHand:
 					case vr::TrackedControllerRole_RightHand: {
 						//if (trackedDevicePose.eTrackingResult == vr::TrackingResult_Running_OK) {
 
-						int hand = (role == vr::TrackedControllerRole_RightHand);
-						steam.mHandControllerDeviceIndex[hand] = i;
-
-						t_symbol * id = hand ? ps_right_hand : ps_left_hand;
+						t_symbol * id = dev.id;
 
 						if (trackedDevicePose.bPoseIsValid) {
 
-							steam_output_tracked_device(id, trackedDevicePose);
+							steam_output_tracked_device(id, i);
 
 						}
 
@@ -1751,6 +3847,30 @@ struct Vr {
 						//OpenVR SDK 1.0.4 adds a 3rd arg for size
 						steam.hmd->GetControllerState(i, &cs, sizeof(cs));
 
+						if (uint32_t * in = record_input(i)) {
+							in[SESSION_INPUT_PACKET] = cs.unPacketNum;
+							in[SESSION_INPUT_PRESSED + 0] = uint32_t(cs.ulButtonPressed);
+							in[SESSION_INPUT_PRESSED + 1] = uint32_t(cs.ulButtonPressed >> 32);
+							in[SESSION_INPUT_TOUCHED + 0] = uint32_t(cs.ulButtonTouched);
+							in[SESSION_INPUT_TOUCHED + 1] = uint32_t(cs.ulButtonTouched >> 32);
+							for (int k = 0; k < (int)vr::k_unControllerStateAxisCount; k++) {
+								in[SESSION_INPUT_AXES + 2 * k + 0] = SessionCodec::float_bits(cs.rAxis[k].x);
+								in[SESSION_INPUT_AXES + 2 * k + 1] = SessionCodec::float_bits(cs.rAxis[k].y);
+							}
+						}
+
+						if (float * row = tracking_row(i, id)) {
+							row[TRACKING_TRIGGER + 0] = (cs.ulButtonTouched & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Trigger)) != 0;
+							row[TRACKING_TRIGGER + 1] = cs.rAxis[1].x;
+							row[TRACKING_PAD + 0] = (cs.ulButtonTouched & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Touchpad)) != 0;
+							row[TRACKING_PAD + 1] = cs.rAxis[0].x;
+							row[TRACKING_PAD + 2] = cs.rAxis[0].y;
+							row[TRACKING_PAD + 3] = (cs.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Touchpad)) != 0;
+							row[TRACKING_BUTTONS + 0] = (cs.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_ApplicationMenu)) != 0;
+							row[TRACKING_BUTTONS + 1] = (cs.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_Grip)) != 0;
+						}
+						if (!tracking_messages) break;
+
 						atom_setsym(a + 0, ps_trigger);
 						atom_setlong(a + 1, (cs.ulButtonTouched & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Trigger)) != 0);
 						atom_setfloat(a + 2, cs.rAxis[1].x);
@@ -1779,15 +3899,10 @@ struct Vr {
 				{
 					if (trackedDevicePose.bPoseIsValid) {
 
-						t_symbol * id = ps_generic;
-						//Figure out which tracker it is using some kind of unique identifier
-						vr::ETrackedPropertyError err = vr::TrackedProp_Success;
-						char buf[vr::k_unMaxPropertyStringSize];
-						if (vr::VRSystem()->GetStringTrackedDeviceProperty(i, vr::Prop_SerialNumber_String, buf, sizeof(buf), &err)) {
-							id = gensym(buf);
-						}
+						// trackers are identified by their (cached) serial number
+						t_symbol * id = dev.id;
 
-						steam_output_tracked_device(id, trackedDevicePose);
+						steam_output_tracked_device(id, i);
 
 					}
 				} break;
@@ -1803,92 +3918,240 @@ struct Vr {
 	}
 
 	// utility function for steam_bang()
-	glm::mat4 steam_output_tracked_device(t_symbol * id, const vr::TrackedDevicePose_t& trackedDevicePose) {
-		t_atom a[5];
+	// uses the batches converted after WaitGetPoses
+	Pose steam_output_tracked_device(t_symbol * id, int index) {
 		
-		glm::mat4 mat = to_glm(trackedDevicePose.mDeviceToAbsoluteTracking);
-
-		glm::vec3 p = glm::vec3(mat[3]); // the translation component
-		glm::quat q = glm::quat_cast(mat); // the orientation component
-										   // adjusted to world space
-		glm::mat4 world_mat = view_mat * mat;
-		glm::vec3 p1 = glm::vec3(world_mat[3]); // the translation component
-		glm::quat q1 = glm::quat_cast(world_mat); // the orientation component
-
-		atom_setsym(a + 0, ps_tracked_position);
-		atom_setfloat(a + 1, p.x);
-		atom_setfloat(a + 2, p.y);
-		atom_setfloat(a + 3, p.z);
-		outlet_anything(outlet_tracking, id, 4, a);
-
-		atom_setsym(a + 0, ps_tracked_quat);
-		atom_setfloat(a + 1, q.x);
-		atom_setfloat(a + 2, q.y);
-		atom_setfloat(a + 3, q.z);
-		atom_setfloat(a + 4, q.w);
-		outlet_anything(outlet_tracking, id, 5, a);
-
-		atom_setsym(a + 0, _jit_sym_position);
-		atom_setfloat(a + 1, p1.x);
-		atom_setfloat(a + 2, p1.y);
-		atom_setfloat(a + 3, p1.z);
-		outlet_anything(outlet_tracking, id, 4, a);
-
-		atom_setsym(a + 0, _jit_sym_quat);
-		atom_setfloat(a + 1, q1.x);
-		atom_setfloat(a + 2, q1.y);
-		atom_setfloat(a + 3, q1.z);
-		atom_setfloat(a + 4, q1.w);
-		outlet_anything(outlet_tracking, id, 5, a);
+		Pose pose = steam.poses.get(index);
+		const vr::TrackedDevicePose_t& trackedDevicePose = steam.pRenderPoseArray[index];
+		if (filter_pose(id, index, pose, to_glm(trackedDevicePose.vVelocity), to_glm(trackedDevicePose.vAngularVelocity))) {
+			output_tracked_pose(id, index, pose);
+		}
+		else {
+			output_tracked_pose(id, index, pose, steam.world_poses.get(index));
+		}
 
 		// velocities:
-		// TODO: check if these are in tracking space
-		glm::vec3 vel = to_glm(trackedDevicePose.vVelocity);
-		glm::vec3 angvel = to_glm(trackedDevicePose.vAngularVelocity);
-		// rotated into world space (TODO is this appropriate? rotate or unrotate?)
-		vel = quat_rotate(view_quat, vel);
-		angvel = quat_rotate(view_quat, angvel);
+		output_world_velocity(id, index, steam.world_velocities.get(index), steam.world_angular_velocities.get(index));
 
-		atom_setsym(a + 0, ps_velocity);
-		atom_setfloat(a + 1, vel.x);
-		atom_setfloat(a + 2, vel.y);
-		atom_setfloat(a + 3, vel.z);
-		outlet_anything(outlet_tracking, id, 4, a);
+		return pose;
+	}
 
-		atom_setsym(a + 0, ps_angular_velocity);
-		atom_setfloat(a + 1, angvel.x);
-		atom_setfloat(a + 2, angvel.y);
-		atom_setfloat(a + 3, angvel.z);
-		outlet_anything(outlet_tracking, id, 4, a);
 
-		return mat;
+	// runs in the poll thread
+	void steam_poll(double t) {
+		if (!steam.hmd) return;
+		vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+		steam.hmd->GetDeviceToAbsoluteTrackingPose(poll_origin, 0.f, poses, vr::k_unMaxTrackedDeviceCount);
+		for (int i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+			const vr::TrackedDevicePose_t& pose = poses[i];
+			if (!pose.bDeviceIsConnected || !pose.bPoseIsValid) continue;
+			Pose p = to_pose(pose.mDeviceToAbsoluteTracking);
+			PoseSample s;
+			s.time = t;
+			s.quat = p.quat;
+			s.position = p.position;
+			s.velocity = to_glm(pose.vVelocity);
+			s.angular_velocity = to_glm(pose.vAngularVelocity);
+			poll_rings[i].write(s);
+		}
 	}
 
-
 	bool steam_copy_texture(GLuint input_texture_id, t_atom_long input_texture_dim[2]) {
 		if (!steam.hmd) return false;
 
 		// main difference here with oculus is that we have to allocate the texture
 		// whereas with oculus, the driver gives us a texture (the textureChain stuff)
 
+		if (!steam_acquire_submit_texture()) {
+			object_error(&ob, "no texture to submit");
+			return false;
+		}
+
 		// TODO: check success
+		PerfScope perf_scope(perf_stages[PERF_COPY], perf_timing != 0);
 		if (!fbo_copy_texture(input_texture_id, input_texture_dim,
-			fbo_id, steam.fbo_texture_id, fbo_dim, false)) {
+			fbo_id, steam.fbo_texture_id, render_dim, false)) {
 			object_error(&ob, "problem copying texture");
 			return false;
 		}
 		return true;
 	}
 
+	// a vr.layer as an overlay, showing a copy of its texture
+	// (the overlay's width sets its size; the height follows the texture's aspect ratio)
+	// returns whether the overlay is shown; copied is set if the content was copied this frame
+	bool steam_layer_update(int i, Layer * layer, GLuint glid, GLenum target, t_atom_long dim[2], bool due, Pose const & pose, bool & copied) {
+		LayerState & state = layer_states[i];
+		vr::IVROverlay * overlays = steam.hmd ? vr::VROverlay() : 0;
+		if (!overlays) return false;
+		std::lock_guard<std::mutex> lock(compositor_mutex);
+
+		if (state.overlay == vr::k_ulOverlayHandleInvalid) {
+			char key[64];
+			snprintf(key, sizeof(key), "max.vr.layer.%p.%d", (void *)this, i);
+			if (overlays->CreateOverlay(key, key, &state.overlay) != vr::VROverlayError_None) {
+				object_error(&ob, "failed to create overlay");
+				state.overlay = vr::k_ulOverlayHandleInvalid;
+				return false;
+			}
+		}
+		if (!state.texture || dim[0] != state.dim[0] || dim[1] != state.dim[1]) {
+			if (!state.texture) glGenTextures(1, &state.texture);
+			glBindTexture(GL_TEXTURE_2D, state.texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, dim[0], dim[1], 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			state.dim[0] = dim[0];
+			state.dim[1] = dim[1];
+			due = true;
+		}
+
+		if (due) {
+			// rows as in the Jitter texture, as for the scene submit
+			if (!fbo_copy_texture(glid, dim, layer_fbo_id, state.texture, dim, false, target)) {
+				object_error(&ob, "problem copying layer texture");
+				return false;
+			}
+			vr::Texture_t vrTexture = { (void*)(uintptr_t)state.texture, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
+			overlays->SetOverlayTexture(state.overlay, &vrTexture);
+			copied = true;
+		}
+
+		overlays->SetOverlayWidthInMeters(state.overlay, layer->width);
+		vr::HmdMatrix34_t m = to_steam(pose);
+		if (layer->head_locked) {
+			overlays->SetOverlayTransformTrackedDeviceRelative(state.overlay, vr::k_unTrackedDeviceIndex_Hmd, &m);
+		}
+		else {
+			overlays->SetOverlayTransformAbsolute(state.overlay, vr::VRCompositor()->GetTrackingSpace(), &m);
+		}
+		overlays->ShowOverlay(state.overlay);
+		return true;
+	}
+
+	// make the least recently submitted texture whose fence has signalled the copy destination
+	// if none has, wait for the oldest (and count it in @submit_waits)
+	bool steam_acquire_submit_texture() {
+		int oldest = -1, ready = -1;
+		for (int i = 0; i < STEAM_SUBMIT_TEXTURES; i++) {
+			if (!steam.submit_textures[i]) continue;
+			// still with the submit thread, which sets the fence once it has submitted:
+			if (steam.submit_pending[i].load(std::memory_order_acquire)) continue;
+			bool signalled = !steam.submit_fences[i] || glClientWaitSync(steam.submit_fences[i], 0, 0) != GL_TIMEOUT_EXPIRED;
+			if (oldest < 0 || steam.submit_frames[i] < steam.submit_frames[oldest]) oldest = i;
+			if (signalled && (ready < 0 || steam.submit_frames[i] < steam.submit_frames[ready])) ready = i;
+		}
+		if (oldest < 0) return false;
+		if (ready < 0) {
+			ready = oldest;
+			submit_waits++;
+			glClientWaitSync(steam.submit_fences[ready], GL_SYNC_FLUSH_COMMANDS_BIT, STEAM_SUBMIT_WAIT_NS);
+		}
+		if (steam.submit_fences[ready]) {
+			glDeleteSync(steam.submit_fences[ready]);
+			steam.submit_fences[ready] = 0;
+		}
+		steam.submit_current = ready;
+		steam.fbo_texture_id = steam.submit_textures[ready];
+		return true;
+	}
+
+	// after submitting a ring texture: fence it, so that it isn't reused before the GPU is done with this frame
+	void steam_fence_submit_texture() {
+		PerfScope perf_scope(perf_stages[PERF_COMMIT], perf_timing != 0);
+		int i = steam.submit_current;
+		if (i < 0) return;
+		steam.submit_fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		steam.submit_frames[i] = ++steam.submit_frame;
+		steam.submit_current = -1;
+	}
+
+	// with @submit_async: queue the ring texture just copied into, for the submit thread to submit & fence
+	bool steam_push_submit_texture() {
+		int i = steam.submit_current;
+		if (i < 0) return false;
+		SubmitJob job;
+		job.driver = ps_steam;
+		job.texid = steam.fbo_texture_id;
+		job.ring = i;
+		job.umax = render_dim[0] / (float)fbo_dim[0];
+		job.vmax = render_dim[1] / (float)fbo_dim[1];
+		steam.submit_pending[i] = 1;
+		if (!submit_async_push(job)) {
+			steam.submit_pending[i] = 0;
+			return false;
+		}
+		steam.submit_frames[i] = ++steam.submit_frame;
+		steam.submit_current = -1;
+		return true;
+	}
+
+	// runs in the submit thread
+	void steam_submit_job(SubmitJob& job) {
+		steam_submit_eyes(job.texid, false, job.umax, job.vmax);
+		if (glfinishhack) glFinish();
+		steam.submit_fences[job.ring] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		// the fence must be flushed before the main thread can wait on it:
+		glFlush();
+		steam.submit_pending[job.ring].store(0, std::memory_order_release);
+	}
+
+	// the compositor samples a GL_TEXTURE_2D directly, so a Jitter texture can be submitted without a copy
+	// if it is 2D (@rectangle 0), already at the capture size (render_dim), and in a format the compositor accepts
+	bool steam_can_submit_directly(void * jit_texture) {
+		if (!steam.hmd) return false;
+		if (object_attr_getlong(jit_texture, gensym("rectangle"))) return false;
+		t_atom_long dim[2];
+		object_attr_getlong_array(jit_texture, _jit_sym_dim, 2, dim);
+		if (dim[0] != render_dim[0] || dim[1] != render_dim[1]) return false;
+		t_symbol * type = object_attr_getsym(jit_texture, _jit_sym_type);
+		return type == _jit_sym_char || type == _jit_sym_float32 || type == gensym("float16");
+	}
+
 	bool steam_submit_texture() {
-		bool flip = is_gl3;
+		if (is_gl3) return steam_submit_texture(steam.fbo_texture_id, true);
+		// the copy only fills render_dim of the texture:
+		return steam_submit_texture(steam.fbo_texture_id, false, 
+			render_dim[0] / (float)fbo_dim[0], render_dim[1] / (float)fbo_dim[1]);
+	}
+
+	// flip: the texture rows are upside-down relative to the input (as after the gl3 copy)
+	// the FBO copy and direct submission keep the rows of the Jitter texture, so they need no flip
+	// umax, vmax: the part of the texture holding the (side-by-side) image
+	bool steam_submit_texture(GLuint texid, bool flip, float umax = 1.f, float vmax = 1.f) {
+		submit_async_drain();
+		PerfScope perf_scope(perf_stages[PERF_SUBMIT], perf_timing != 0);
+		steam_submit_eyes(texid, flip, umax, vmax);
+
+		if (glfinishhack) {
+			// no longer needed for the copy path, since submit textures are used in turn (see steam_acquire_submit_texture)
+			// but kept for drivers that still need it
+			// is this necessary?
+			glClearColor(0, 0, 0, 1);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// openvr header recommends this after submit:
+			glFlush();
+			glFinish();
+
+			// issue on openvr suggests only this is needed
+			// https://github.com/ValveSoftware/openvr/issues/460
+			// glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+		}
+		return true;
+	}
+
+	// the compositor calls, from the main thread or the submit thread
+	void steam_submit_eyes(GLuint texid, bool flip, float umax, float vmax) {
+		std::lock_guard<std::mutex> lock(compositor_mutex);
 		vr::EVRCompositorError err;
 		//GraphicsAPIConvention enum was renamed to TextureType in OpenVR SDK 1.0.5
 		// TODO: expose different colour options as attributes?
-		vr::Texture_t vrTexture = { (void*)steam.fbo_texture_id, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
+		vr::Texture_t vrTexture = { (void*)(uintptr_t)texid, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
 
-		vr::VRTextureBounds_t leftBounds = { 0.f, (flip ? 1.f : 0.f), 0.5f, (!flip ? 1.f : 0.f) };
-		vr::VRTextureBounds_t rightBounds = { 0.5f, (flip ? 1.f : 0.f), 1.f, (!flip ? 1.f : 0.f) };
+		vr::VRTextureBounds_t leftBounds = { 0.f, (flip ? vmax : 0.f), 0.5f * umax, (!flip ? vmax : 0.f) };
+		vr::VRTextureBounds_t rightBounds = { 0.5f * umax, (flip ? vmax : 0.f), umax, (!flip ? vmax : 0.f) };
 
 		err = vr::VRCompositor()->Submit(vr::Eye_Left, &vrTexture, &leftBounds);
 		switch (err) {
@@ -1967,21 +4230,6 @@ struct Vr {
 			object_error(&ob, "submit error: other");
 			break;
 		}
-
-		if (glfinishhack) {
-			// is this necessary?
-			glClearColor(0, 0, 0, 1);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			// openvr header recommends this after submit:
-			glFlush();
-			glFinish();
-
-			// issue on openvr suggests only this is needed
-			// https://github.com/ValveSoftware/openvr/issues/460
-			// glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
-		}
-		return true;
 	}
 
 	bool steam_video_restart() {
@@ -2127,12 +4375,350 @@ struct Vr {
 		}
 	}
 #endif
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// driver replay: plays a recorded session file back through the same outputs as a live device
+	// @replay_mode realtime: frames are played at their recorded times (skipping frames if bang() is slower)
+	// @replay_mode step: each step message advances one frame; bang() repeats the current frame
+	// @replay_mode fast: each bang() advances one frame, regardless of time
+
+	bool replay_connect() {
+		if (replay_file == _jit_sym_nothing) {
+			object_error(&ob, "replay: no @replay_file");
+			return false;
+		}
+		char fullpath[MAX_PATH_CHARS], native[MAX_PATH_CHARS];
+		short path;
+		t_fourcc type;
+		strncpy(fullpath, replay_file->s_name, MAX_PATH_CHARS - 1);
+		fullpath[MAX_PATH_CHARS - 1] = 0;
+		if (!locatefile_extended(fullpath, &path, &type, NULL, 0)) {
+			path_toabsolutesystempath(path, fullpath, native);
+		}
+		else {
+			path_nameconform(replay_file->s_name, native, PATH_STYLE_NATIVE, PATH_TYPE_BOOT);
+		}
+		if (!replay.reader.open(native)) {
+			object_error(&ob, "replay: couldn't read session file %s", native);
+			return false;
+		}
+		replay_rewind();
+		return true;
+	}
+
+	void replay_disconnect() {
+		replay.reader.close();
+	}
+
+	void replay_rewind() {
+		replay.reader.rewind();
+		replay.frames = 0;
+		replay.numevents = 0;
+		replay.ended = false;
+		replay.start = PoseChannel::now();
+	}
+
+	// decode the next frame, keeping its events until the next bang()
+	// at the end of the file, either loops or reports the end (once)
+	bool replay_next() {
+		if (!replay.reader.next(replay.frame)) {
+			if (replay_loop && replay.frames) {
+				replay_rewind();
+				return replay.reader.next(replay.frame) && replay_decoded();
+			}
+			if (!replay.ended) {
+				replay.ended = true;
+				t_atom a[1];
+				atom_setlong(a, replay.frames);
+				outlet_anything(outlet_msg, gensym("replay_end"), 1, a);
+			}
+			return false;
+		}
+		return replay_decoded();
+	}
+
+	bool replay_decoded() {
+		replay.frames++;
+		for (int i = 0; i < replay.frame.numevents && replay.numevents < SESSION_MAX_EVENTS; i++) {
+			replay.events[replay.numevents++] = replay.frame.events[i];
+		}
+		return true;
+	}
+
+	// step [n]: advance n frames (default 1)
+	void replay_step(int n) {
+		if (!connected || driver != ps_replay) return;
+		if (n < 1) n = 1;
+		while (n-- && replay_next()) {}
+	}
+
+	// seek <seconds>: jump to a time in the recording (events in between are skipped)
+	void replay_seek(double t) {
+		if (!connected || driver != ps_replay) return;
+		if (!replay.reader.seek(t, replay.frame)) return;
+		replay.frames++;
+		replay.numevents = 0;
+		replay.ended = false;
+		replay.start = PoseChannel::now() - replay.frame.time;
+	}
+
+	void replay_bang() {
+		if (replay_mode == ps_realtime) {
+			double t = PoseChannel::now() - replay.start;
+			double ft;
+			while (replay.reader.peek_time(ft) && ft <= t) {
+				if (!replay_next()) break;
+			}
+			if (replay.reader.at_end()) replay_next(); // loop, or report the end
+		}
+		else if (replay_mode == ps_fast || !replay.frames) {
+			replay_next();
+		}
+		if (!replay.frames) return;
+		const SessionFrame& frame = replay.frame;
+
+		// eyes:
+		for (int eye = 0; eye < 2; eye++) {
+			const float * e = frame.eyes[eye];
+			eye_pose[eye] = Pose(glm::quat(e[6], e[3], e[4], e[5]), glm::vec3(e[0], e[1], e[2]));
+			// rescale the recorded frustum to the current @near_clip:
+			float scale = e[11] > 0.f ? near_clip / e[11] : 1.f;
+			output_frustum(eye, e[7] * scale, e[8] * scale, e[9] * scale, e[10] * scale);
+		}
+
+		// devices:
+		for (int i = 0; i < frame.numdevices; i++) {
+			const SessionDevice& dev = frame.devices[i];
+			const float * row = dev.row;
+			t_symbol * id = gensym(dev.name);
+
+			Pose pose(glm::quat(row[TRACKING_TRACKED_QUAT + 3], row[TRACKING_TRACKED_QUAT + 0], row[TRACKING_TRACKED_QUAT + 1], row[TRACKING_TRACKED_QUAT + 2]),
+				glm::vec3(row[TRACKING_TRACKED_POSITION + 0], row[TRACKING_TRACKED_POSITION + 1], row[TRACKING_TRACKED_POSITION + 2]));
+			if (id == ps_head) head_pose = pose;
+			output_tracked_pose(id, dev.index, pose);
+
+			// recorded velocities are in world space; output_tracked_velocity expects tracking space:
+			glm::vec3 vel(row[TRACKING_VELOCITY + 0], row[TRACKING_VELOCITY + 1], row[TRACKING_VELOCITY + 2]);
+			glm::vec3 angvel(row[TRACKING_ANGULAR_VELOCITY + 0], row[TRACKING_ANGULAR_VELOCITY + 1], row[TRACKING_ANGULAR_VELOCITY + 2]);
+			output_tracked_velocity(id, dev.index, view_pose.unrotate(vel), view_pose.unrotate(angvel));
+
+			if (id == ps_left_hand || id == ps_right_hand) {
+				output_tracked_input(id, dev.index, row);
+			}
+			if (dev.has_input) {
+				if (uint32_t * in = record_input(dev.index)) memcpy(in, dev.input, sizeof(dev.input));
+			}
+		}
+
+		// events:
+		t_atom a[1];
+		for (int i = 0; i < replay.numevents; i++) {
+			const SessionEvent& event = replay.events[i];
+			switch (event.type) {
+			case vr::VREvent_TrackedDeviceActivated:
+				atom_setlong(a, event.device);
+				outlet_anything(outlet_msg, gensym("attached"), 1, a);
+				break;
+			case vr::VREvent_TrackedDeviceDeactivated:
+				atom_setlong(a, event.device);
+				outlet_anything(outlet_msg, gensym("detached"), 1, a);
+				break;
+			default: break;
+			}
+			if (recording()) record_event(event.type, event.device, event.age, event.data, SESSION_EVENT_DATA);
+		}
+		replay.numevents = 0;
+	}
+
+	// controller state, as stored in a device row (by replay & sim)
+	void output_tracked_input(t_symbol * id, int index, const float * row) {
+		t_atom a[5];
+		if (float * out = tracking_row(index, id)) {
+			memcpy(out + TRACKING_TRIGGER, row + TRACKING_TRIGGER, (TRACKING_COLUMNS - TRACKING_TRIGGER) * sizeof(float));
+		}
+		if (!tracking_messages) return;
+
+		atom_setsym(a + 0, ps_trigger);
+		atom_setlong(a + 1, row[TRACKING_TRIGGER + 0] != 0.f);
+		atom_setfloat(a + 2, row[TRACKING_TRIGGER + 1]);
+		outlet_anything(outlet_tracking, id, 3, a);
+
+		atom_setsym(a + 0, ps_hand_trigger);
+		atom_setlong(a + 1, row[TRACKING_HAND_TRIGGER + 0] != 0.f);
+		atom_setfloat(a + 2, row[TRACKING_HAND_TRIGGER + 1]);
+		outlet_anything(outlet_tracking, id, 3, a);
+
+		atom_setsym(a + 0, ps_pad);
+		atom_setlong(a + 1, row[TRACKING_PAD + 0] != 0.f);
+		atom_setfloat(a + 2, row[TRACKING_PAD + 1]);
+		atom_setfloat(a + 3, row[TRACKING_PAD + 2]);
+		atom_setlong(a + 4, row[TRACKING_PAD + 3] != 0.f);
+		outlet_anything(outlet_tracking, id, 5, a);
+
+		atom_setsym(a + 0, ps_buttons);
+		atom_setlong(a + 1, row[TRACKING_BUTTONS + 0] != 0.f);
+		atom_setlong(a + 2, row[TRACKING_BUTTONS + 1] != 0.f);
+		outlet_anything(outlet_tracking, id, 3, a);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// driver sim: a head, two hands and (@sim_devices - 3) trackers moving procedurally,
+	// with controller activity and (@sim_events per second) tracker attach/detach events
+	// it goes through the same connect/configure/bang path & outputs as the hardware drivers
+
+	bool sim_connect() {
+		char name[32];
+		for (int i = 0; i < VR_MAX_TRACKED_DEVICES; i++) {
+			switch (i) {
+			case 0: sim.ids[i] = ps_head; break;
+			case 1: sim.ids[i] = ps_left_hand; break;
+			case 2: sim.ids[i] = ps_right_hand; break;
+			default:
+				snprintf(name, sizeof(name), "tracker_%d", i);
+				sim.ids[i] = gensym(name);
+			}
+			sim.live[i] = true;
+		}
+		sim.start = PoseChannel::now();
+		sim.last = 0.;
+		sim.event_accum = 0.;
+		sim.rng = 1;
+		sim.next_frame = std::chrono::steady_clock::now();
+		// a typical current headset:
+		fbo_dim[0] = 2 * 1080;
+		fbo_dim[1] = 1200;
+		return true;
+	}
+
+	uint32_t sim_random() {
+		// xorshift32; deterministic so that runs are comparable
+		sim.rng ^= sim.rng << 13;
+		sim.rng ^= sim.rng >> 17;
+		sim.rng ^= sim.rng << 5;
+		return sim.rng;
+	}
+
+	// pose of device i at time t (seconds), in tracking space
+	Pose sim_pose(int i, double t) {
+		float ft = float(t);
+		glm::vec3 p;
+		glm::quat q;
+		if (i == 0) {
+			// head: standing, looking around
+			p = glm::vec3(0.1f * sinf(ft * 0.4f), 1.6f + 0.02f * sinf(ft * 1.3f), 0.1f * sinf(ft * 0.3f));
+			q = glm::angleAxis(0.6f * sinf(ft * 0.5f), glm::vec3(0, 1, 0)) * glm::angleAxis(0.2f * sinf(ft * 0.3f), glm::vec3(1, 0, 0));
+		}
+		else if (i < 3) {
+			// hands: small circles in front of the body
+			float side = i == 1 ? -1.f : 1.f;
+			float a = ft * 1.5f * side;
+			p = glm::vec3(side * 0.25f + 0.1f * cosf(a), 1.1f + 0.1f * sinf(a), -0.35f);
+			q = glm::angleAxis(0.5f * sinf(ft), glm::vec3(0, 0, 1));
+		}
+		else {
+			// trackers: orbiting the play area at different radii & speeds
+			float r = 1.f + 0.03f * float(i);
+			float a = ft * (0.2f + 0.01f * float(i)) + float(i);
+			p = glm::vec3(r * cosf(a), 0.2f + 0.025f * float(i), r * sinf(a));
+			q = glm::angleAxis(-a, glm::vec3(0, 1, 0));
+		}
+		return Pose(q, p);
+	}
+
+	void sim_bang() {
+		// pace like a compositor would:
+		if (sim_rate > 0.) {
+			PerfScope perf_scope(perf_stages[PERF_WAIT], perf_timing != 0);
+			auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1. / sim_rate));
+			sim.next_frame += period;
+			auto now = std::chrono::steady_clock::now();
+			if (sim.next_frame < now) sim.next_frame = now; // missed a frame
+			else std::this_thread::sleep_until(sim.next_frame);
+		}
+		double t = PoseChannel::now() - sim.start;
+		double dt = t - sim.last;
+		sim.last = t;
+		int count = (int)AL_MIN(AL_MAX(sim_devices, 1), VR_MAX_TRACKED_DEVICES);
+
+		// tracker attach/detach events:
+		t_atom a[1];
+		if (count > 3 && sim_events > 0.) {
+			sim.event_accum += dt * sim_events;
+			for (; sim.event_accum >= 1.; sim.event_accum -= 1.) {
+				int i = 3 + sim_random() % (count - 3);
+				sim.live[i] = !sim.live[i];
+				uint32_t type = sim.live[i] ? vr::VREvent_TrackedDeviceActivated : vr::VREvent_TrackedDeviceDeactivated;
+				if (recording()) record_event(type, i);
+				atom_setlong(a, i);
+				outlet_anything(outlet_msg, gensym(sim.live[i] ? "attached" : "detached"), 1, a);
+			}
+		}
+
+		// velocities by finite difference:
+		const double h = 0.001;
+		for (int i = 0; i < count; i++) {
+			if (!sim.live[i]) continue;
+			t_symbol * id = sim.ids[i];
+			Pose pose = sim_pose(i, t);
+			Pose pose1 = sim_pose(i, t + h);
+			glm::vec3 vel = (pose1.position - pose.position) / float(h);
+			glm::quat dq = pose1.quat * glm::conjugate(pose.quat);
+			if (dq.w < 0.f) dq = -dq; // shortest arc
+			glm::vec3 angvel = glm::axis(dq) * (glm::angle(dq) / float(h));
+
+			filter_pose(id, i, pose, vel, angvel);
+			output_tracked_pose(id, i, pose);
+			output_tracked_velocity(id, i, vel, angvel);
+
+			if (i == 0) {
+				head_pose = pose;
+				for (int eye = 0; eye < 2; eye++) {
+					float ipd = 0.064f;
+					eye_pose[eye] = pose * Pose(glm::quat(), glm::vec3(eye ? ipd / 2.f : -ipd / 2.f, 0.f, -0.095f));
+					output_frustum(eye, (eye ? -0.95f : -1.05f) * near_clip, (eye ? 1.05f : 0.95f) * near_clip, -1.1f * near_clip, 1.1f * near_clip);
+				}
+			}
+			else if (i < 3) {
+				// controller activity:
+				float row[TRACKING_COLUMNS] = { 0 };
+				float ft = float(t) + float(i);
+				float trigger = AL_MAX(0.f, sinf(ft * 2.f));
+				row[TRACKING_TRIGGER + 0] = trigger > 0.05f;
+				row[TRACKING_TRIGGER + 1] = trigger;
+				row[TRACKING_HAND_TRIGGER + 1] = AL_MAX(0.f, cosf(ft * 0.7f));
+				row[TRACKING_HAND_TRIGGER + 0] = row[TRACKING_HAND_TRIGGER + 1] > 0.25f;
+				row[TRACKING_PAD + 1] = cosf(ft * 3.f);
+				row[TRACKING_PAD + 2] = sinf(ft * 3.f);
+				row[TRACKING_PAD + 0] = fmodf(ft, 2.f) < 1.5f;
+				row[TRACKING_PAD + 3] = fmodf(ft, 2.f) < 0.25f;
+				row[TRACKING_BUTTONS + 0] = fmodf(ft, 1.f) < 0.1f;
+				row[TRACKING_BUTTONS + 1] = fmodf(ft, 3.f) < 0.2f;
+				output_tracked_input(id, i, row);
+			}
+		}
+	}
 };
 
 void vr_connect(Vr * x) { x->connect(); }
 void vr_disconnect(Vr * x) { x->disconnect(); }
 void vr_configure(Vr * x) { x->configure(); }
 void vr_bang(Vr * x) { x->bang(); }
+void vr_latch(Vr * x) { x->latch(); }
+void vr_schedule_clock(Vr * x) { qelem_set(x->schedule_qelem); }
+void vr_schedule_tick(Vr * x) { x->schedule_tick(); }
+void vr_detect_done(Vr * x) { x->detect_done(); }
+
+// runs in the detector thread
+void vr_detect(Availability& result) {
+#ifdef USE_OCULUS_DRIVER
+	result.oculus = Vr::oculus_is_available();
+#endif
+#ifdef USE_STEAM_DRIVER
+	result.steam = Vr::steam_is_available();
+#endif
+}
 
 void vr_jit_gl_texture(Vr * x, t_symbol * s, long argc, t_atom * argv) {
 	if (argc > 0 && atom_gettype(argv) == A_SYM) {
@@ -2141,11 +4727,6 @@ void vr_jit_gl_texture(Vr * x, t_symbol * s, long argc, t_atom * argv) {
 }
 
 /*
-
-void oculusrift_perf(oculusrift * x) {
-x->perf();
-}
-
 void oculusrift_recenter(oculusrift * x) {
 if (x->session) ovr_RecenterTrackingOrigin(x->session);
 }*/
@@ -2158,7 +4739,27 @@ void vr_draw(Vr * x) {} // not used
 void vr_haptic(Vr * x, t_atom_long hand, t_atom_float intensity) { x->haptic(hand, intensity); }
 
 void vr_battery(Vr * x) { x->battery(); }
+
+void vr_poll(Vr * x) { x->poll(); }
+void vr_poll_latest(Vr * x) { x->poll_latest(); }
+void vr_poll_at(Vr * x, double t) { x->poll_at(t); }
+
+void vr_record(Vr * x, t_symbol * name) { x->record(name); }
+void vr_stop(Vr * x) { x->record_stop(); }
+
+void vr_filter_device(Vr * x, t_symbol * s, long argc, t_atom * argv) { x->filter_device(argc, argv); }
+
+void vr_step(Vr * x, t_atom_long n) { x->replay_step(n); }
+void vr_seek(Vr * x, double t) { x->replay_seek(t); }
+
+t_max_err vr_poll_rate_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
+	x->poll_stop();
+	x->poll_rate = AL_MIN(AL_MAX(atom_getfloat(argv), 0.), 2000.);
+	x->poll_start();
+	return 0;
+}
 void vr_boundary(Vr * x) { x->boundary(); }
+void vr_perf(Vr * x, t_symbol * arg) { x->perf_message(arg); }
 
 t_max_err vr_use_camera_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
 	x->use_camera = atom_getlong(argv);
@@ -2178,6 +4779,13 @@ t_max_err vr_use_camera_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
 	return 0;
 }
 
+t_max_err vr_availability_age_get(Vr *x, t_object *attr, long *argc, t_atom **argv) {
+	char alloc;
+	atom_alloc(argc, argv, &alloc);
+	atom_setfloat(*argv, x->availability_time < 0. ? -1. : AvailabilityDetector::now() - x->availability_time);
+	return 0;
+}
+
 t_max_err vr_connected_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
 	t_atom_long l = atom_getlong(argv);
 	if (x->connected != l) {
@@ -2214,6 +4822,16 @@ t_max_err vr_driver_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
 	return 0;
 }
 
+t_max_err vr_pose_channel_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
+	x->pose_channel_name = argc ? atom_getsym(argv) : _jit_sym_nothing;
+	x->pose_channel = 0;
+	if (x->pose_channel_name != _jit_sym_nothing) {
+		x->pose_channel = PoseChannel::find(gensym, x->pose_channel_name->s_name);
+		if (!x->pose_channel) object_error(&x->ob, "cannot use pose channel %s", x->pose_channel_name->s_name);
+	}
+	return 0;
+}
+
 t_max_err vr_near_clip_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
 	x->near_clip = atom_getfloat(argv);
 	x->configure();
@@ -2226,6 +4844,30 @@ t_max_err vr_far_clip_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
 	return 0;
 }
 
+t_max_err vr_mirror_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
+	x->mirror = atom_getsym(argv);
+	x->mirror_dirty = true;
+	return 0;
+}
+
+t_max_err vr_submit_async_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
+	x->submit_async = atom_getlong(argv);
+	// (started again on the next submit, which happens in the GL context)
+	if (!x->submit_async) x->submit_async_stop();
+	return 0;
+}
+t_max_err vr_schedule_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
+	x->schedule = atom_getlong(argv);
+	if (x->schedule) x->schedule_next();
+	else x->schedule_stop();
+	return 0;
+}
+t_max_err vr_render_scale_set(Vr *x, t_object *attr, long argc, t_atom *argv) {
+	x->render_scale = atom_getfloat(argv);
+	x->render_scale_update();
+	return 0;
+}
+
 /*
 
 t_max_err oculusrift_pixel_density_set(oculusrift *x, t_object *attr, long argc, t_atom *argv) {
@@ -2321,6 +4963,27 @@ void ext_main(void* r) {
 
 	ps_oculus = gensym("oculus");
 	ps_steam = gensym("steam");
+	ps_replay = gensym("replay");
+	ps_sim = gensym("sim");
+	ps_realtime = gensym("realtime");
+	ps_step = gensym("step");
+	ps_fast = gensym("fast");
+	ps_one_euro = gensym("one_euro");
+	ps_kalman = gensym("kalman");
+
+	ps_messages = gensym("messages");
+	ps_matrix = gensym("matrix");
+	ps_dictionary = gensym("dictionary");
+	ps_sample = gensym("sample");
+	ps_record = gensym("record");
+	ps_direct = gensym("direct");
+	ps_copy = gensym("copy");
+	ps_gl3_copy = gensym("gl3_copy");
+	ps_mirror = gensym("mirror");
+	ps_left = gensym("left");
+	ps_right = gensym("right");
+	ps_both = gensym("both");
+	ps_distorted = gensym("distorted");
 
 	this_class = class_new("vr", (method)vr_new, (method)vr_free, sizeof(Vr), 0L, A_GIMME, 0);
 	
@@ -2354,6 +5017,7 @@ void ext_main(void* r) {
  	class_addmethod(this_class, (method)vr_disconnect, "disconnect", 0);
  	class_addmethod(this_class, (method)vr_configure, "configure", 0);
 	class_addmethod(this_class, (method)vr_bang, "bang", 0);
+	class_addmethod(this_class, (method)vr_latch, "latch", 0);
  	class_addmethod(this_class, (method)vr_jit_gl_texture, "jit_gl_texture", A_GIMME, 0);
 
 
@@ -2361,6 +5025,21 @@ void ext_main(void* r) {
 	class_addmethod(this_class, (method)vr_battery, "battery", 0);
 	class_addmethod(this_class, (method)vr_haptic, "vibrate", A_LONG, A_FLOAT, 0);
 
+	// high-rate pose sampling (see @poll_rate):
+	class_addmethod(this_class, (method)vr_poll, "poll", 0);
+	class_addmethod(this_class, (method)vr_poll_latest, "poll_latest", 0);
+	class_addmethod(this_class, (method)vr_poll_at, "poll_at", A_FLOAT, 0);
+
+	class_addmethod(this_class, (method)vr_record, "record", A_DEFSYM, 0);
+	class_addmethod(this_class, (method)vr_stop, "stop", 0);
+
+	class_addmethod(this_class, (method)vr_filter_device, "filter_device", A_GIMME, 0);
+
+	class_addmethod(this_class, (method)vr_step, "step", A_DEFLONG, 0);
+	class_addmethod(this_class, (method)vr_seek, "seek", A_FLOAT, 0);
+
+	class_addmethod(this_class, (method)vr_perf, "perf", A_DEFSYM, 0);
+
 	// vive only
 	CLASS_ATTR_ATOM_LONG(this_class, "use_camera", 0, Vr, use_camera);
 	CLASS_ATTR_ENUMINDEX4(this_class, "use_camera", 0, "no video", "distorted", "undistorted", "undistorted_maximized");
@@ -2368,7 +5047,6 @@ void ext_main(void* r) {
 
 	// oculus only?
 
-	//class_addmethod(c, (method)oculusrift_perf, "perf", 0);
 	//class_addmethod(c, (method)oculusrift_recenter, "recenter", 0);
 	//CLASS_ATTR_FLOAT(c, "pixel_density", 0, oculusrift, pixel_density);
 	//CLASS_ATTR_ACCESSORS(c, "pixel_density", NULL, oculusrift_pixel_density_set);
@@ -2394,19 +5072,116 @@ void ext_main(void* r) {
 	CLASS_ATTR_STYLE(this_class, "connected", 0, "onoff");
 
 
+	// output the compositor's view as 'mirror <texture> [<texture>]' after each submitted frame:
+	// none, both (side-by-side; on SteamVR as two textures), left, right, or distorted (Oculus only)
+	CLASS_ATTR_SYM(this_class, "mirror", 0, Vr, mirror);
+	CLASS_ATTR_ENUM(this_class, "mirror", 0, "none both left right distorted");
+	CLASS_ATTR_ACCESSORS(this_class, "mirror", NULL, vr_mirror_set);
+
+	// fraction of the recommended texture size to capture at (see the render_scale message for the resulting dim)
+	CLASS_ATTR_FLOAT(this_class, "render_scale", 0, Vr, render_scale);
+	CLASS_ATTR_ACCESSORS(this_class, "render_scale", NULL, vr_render_scale_set);
+	// adapt render_scale, within render_scale_min..render_scale_max, to keep the GPU time per frame
+	// below render_headroom of the display's frame period
+	CLASS_ATTR_ATOM_LONG(this_class, "render_adapt", 0, Vr, render_adapt);
+	CLASS_ATTR_STYLE(this_class, "render_adapt", 0, "onoff");
+	CLASS_ATTR_FLOAT(this_class, "render_scale_min", 0, Vr, render_scale_min);
+	CLASS_ATTR_FILTER_CLIP(this_class, "render_scale_min", 0.1, 1.);
+	CLASS_ATTR_FLOAT(this_class, "render_scale_max", 0, Vr, render_scale_max);
+	CLASS_ATTR_FILTER_CLIP(this_class, "render_scale_max", 0.1, 1.);
+	CLASS_ATTR_FLOAT(this_class, "render_headroom", 0, Vr, render_headroom);
+	CLASS_ATTR_FILTER_CLIP(this_class, "render_headroom", 0.1, 1.);
+
+	// let vr bang itself at the best moment in each display frame, followed by 'frame <n>'
+	// (stop any metro banging it); schedule_margin is the slack in ms, schedule_cost the measured cost of a frame
+	CLASS_ATTR_ATOM_LONG(this_class, "schedule", 0, Vr, schedule);
+	CLASS_ATTR_STYLE(this_class, "schedule", 0, "onoff");
+	CLASS_ATTR_ACCESSORS(this_class, "schedule", NULL, vr_schedule_set);
+	CLASS_ATTR_DOUBLE(this_class, "schedule_margin", 0, Vr, schedule_margin);
+	CLASS_ATTR_FILTER_MIN(this_class, "schedule_margin", 0.);
+	CLASS_ATTR_DOUBLE(this_class, "schedule_cost", ATTR_SET_OPAQUE | ATTR_SET_OPAQUE_USER, Vr, schedule_cost);
+	// with @schedule, predict the eye poses again just before 'frame' (see the latch message; Oculus only)
+	CLASS_ATTR_ATOM_LONG(this_class, "late_latch", 0, Vr, late_latch);
+	CLASS_ATTR_STYLE(this_class, "late_latch", 0, "onoff");
+
+	// time the stages of each frame, for the perf message (which reports p50, p95, p99, max & mean of the last 512)
+	CLASS_ATTR_ATOM_LONG(this_class, "perf_timing", 0, Vr, perf_timing);
+	CLASS_ATTR_STYLE(this_class, "perf_timing", 0, "onoff");
+	// with @perf_timing, also send the stats as a matrix on every bang
+	CLASS_ATTR_ATOM_LONG(this_class, "perf_stream", 0, Vr, perf_stream);
+	CLASS_ATTR_STYLE(this_class, "perf_stream", 0, "onoff");
+
+	// direct: the texture was handed to the driver as-is; copy/gl3_copy: it was first copied into a driver texture
+	CLASS_ATTR_SYM(this_class, "submit_path", ATTR_SET_OPAQUE | ATTR_SET_OPAQUE_USER, Vr, submit_path);
+	// CPU time in ms of handing each texture to the driver (the GPU work is not included), to compare the paths
+	CLASS_ATTR_DOUBLE(this_class, "submit_time", ATTR_SET_OPAQUE | ATTR_SET_OPAQUE_USER, Vr, submit_time);
+	// hand each copied frame to the compositor from a thread with a shared GL context, rather than waiting on it in the main thread
+	CLASS_ATTR_ATOM_LONG(this_class, "submit_async", 0, Vr, submit_async);
+	CLASS_ATTR_ACCESSORS(this_class, "submit_async", NULL, vr_submit_async_set);
+	CLASS_ATTR_STYLE(this_class, "submit_async", 0, "onoff");
+	// with @submit_async: frames queued for that thread (at most 2), and the ms it spends waiting on each
+	CLASS_ATTR_ATOM_LONG(this_class, "submit_queue", ATTR_SET_OPAQUE | ATTR_SET_OPAQUE_USER, Vr, submit_queue);
+	CLASS_ATTR_DOUBLE(this_class, "submit_wait_time", ATTR_SET_OPAQUE | ATTR_SET_OPAQUE_USER, Vr, submit_wait_time);
+
 	CLASS_ATTR_ATOM_LONG(this_class, "glfinishhack", 0, Vr, glfinishhack);
 	CLASS_ATTR_STYLE(this_class, "glfinishhack", 0, "onoff");
+	// how many times a SteamVR submit had to wait for the GPU to finish with an earlier frame's texture
+	CLASS_ATTR_ATOM_LONG(this_class, "submit_waits", ATTR_SET_OPAQUE | ATTR_SET_OPAQUE_USER, Vr, submit_waits);
 
 	CLASS_ATTR_ATOM_LONG(this_class, "oculus_available", ATTR_SET_OPAQUE | ATTR_SET_OPAQUE_USER, Vr, oculus_available);
 	CLASS_ATTR_STYLE(this_class, "oculus_available", 0, "onoff");
 	CLASS_ATTR_ATOM_LONG(this_class, "steam_available", ATTR_SET_OPAQUE | ATTR_SET_OPAQUE_USER, Vr, steam_available);
 	CLASS_ATTR_STYLE(this_class, "steam_available", 0, "onoff");
+	// seconds since the availability above was detected (-1 if not yet)
+	CLASS_ATTR_DOUBLE(this_class, "availability_age", ATTR_SET_OPAQUE | ATTR_SET_OPAQUE_USER, Vr, availability_time);
+	CLASS_ATTR_ACCESSORS(this_class, "availability_age", vr_availability_age_get, NULL);
 
 	CLASS_ATTR_SYM(this_class, "driver", 0, Vr, driver);
 	CLASS_ATTR_ACCESSORS(this_class, "driver", NULL, vr_driver_set);
 	CLASS_ATTR_ATOM_LONG(this_class, "preferred_driver_only", 0, Vr, preferred_driver_only);
 	CLASS_ATTR_STYLE(this_class, "preferred_driver_only", 0, "onoff");
 
+	// driver replay:
+	CLASS_ATTR_SYM(this_class, "replay_file", 0, Vr, replay_file);
+	CLASS_ATTR_STYLE(this_class, "replay_file", 0, "file");
+	CLASS_ATTR_SYM(this_class, "replay_mode", 0, Vr, replay_mode);
+	CLASS_ATTR_ENUM(this_class, "replay_mode", 0, "realtime step fast");
+	CLASS_ATTR_ATOM_LONG(this_class, "replay_loop", 0, Vr, replay_loop);
+	CLASS_ATTR_STYLE(this_class, "replay_loop", 0, "onoff");
+
+	// driver sim:
+	CLASS_ATTR_ATOM_LONG(this_class, "sim_devices", 0, Vr, sim_devices);
+	CLASS_ATTR_FILTER_CLIP(this_class, "sim_devices", 1, VR_MAX_TRACKED_DEVICES);
+	CLASS_ATTR_DOUBLE(this_class, "sim_rate", 0, Vr, sim_rate);
+	CLASS_ATTR_FILTER_MIN(this_class, "sim_rate", 0);
+	CLASS_ATTR_DOUBLE(this_class, "sim_events", 0, Vr, sim_events);
+	CLASS_ATTR_FILTER_MIN(this_class, "sim_events", 0);
+
+	// messages: separate messages per device & property
+	// matrix: one float32 jit.matrix per frame, one row per device index, 
+	// plus a dictionary of device names whenever the set of devices changes
+	CLASS_ATTR_SYM(this_class, "tracking_format", 0, Vr, tracking_format);
+	CLASS_ATTR_ENUM(this_class, "tracking_format", 0, "messages matrix");
+
+	// per-device pose smoothing (see also the filter_device message)
+	// one_euro uses filter_mincutoff (Hz) & filter_beta; kalman uses filter_process_noise & filter_measurement_noise
+	CLASS_ATTR_SYM(this_class, "filter", 0, Vr, filter);
+	CLASS_ATTR_ENUM(this_class, "filter", 0, "none one_euro kalman");
+	CLASS_ATTR_FLOAT(this_class, "filter_mincutoff", 0, Vr, filter_mincutoff);
+	CLASS_ATTR_FLOAT(this_class, "filter_beta", 0, Vr, filter_beta);
+	CLASS_ATTR_FLOAT(this_class, "filter_process_noise", 0, Vr, filter_process_noise);
+	CLASS_ATTR_FLOAT(this_class, "filter_measurement_noise", 0, Vr, filter_measurement_noise);
+
+	// rate (Hz) of a background thread sampling device poses; 0 to disable
+	// samples are read with the poll, poll_latest and poll_at messages
+	// (rendering still uses the poses from bang())
+	CLASS_ATTR_DOUBLE(this_class, "poll_rate", 0, Vr, poll_rate);
+	CLASS_ATTR_ACCESSORS(this_class, "poll_rate", NULL, vr_poll_rate_set);
+
+	// name of a process-wide channel to publish the head pose to, for audio objects with the same @pose_channel
+	CLASS_ATTR_SYM(this_class, "pose_channel", 0, Vr, pose_channel_name);
+	CLASS_ATTR_ACCESSORS(this_class, "pose_channel", NULL, vr_pose_channel_set);
+
 
 	
 	class_register(CLASS_BOX, this_class);
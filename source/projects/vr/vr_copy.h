@@ -0,0 +1,153 @@
+#ifndef vr_copy_h
+#define vr_copy_h
+
+/*
+	Copying a Jitter texture into a driver texture, through framebuffers.
+
+	vr_blit_texture() is the normal path: a framebuffer blit, which only depends on the framebuffer
+	bindings and the scissor test, so only those are saved & restored. There's no need to clear first,
+	since the blit writes every pixel.
+
+	vr_draw_texture() is the fallback, for when the blit framebuffers can't be completed:
+	a textured quad through the fixed-function pipeline, saving & restoring all GL state around it.
+
+	Both take the destination size as the whole of the destination texture, and with flipY
+	turn GL's bottom-up rows top-down. Neither needs the Max SDK, so that the copies can be
+	timed & checked on their own (see source/tests/bench_copy.cpp).
+
+	Include after the GL headers (jit.gl.h, or the system's with the EXT framebuffer functions).
+*/
+
+// returns false, without copying, if the blit framebuffers can't be completed
+// read_fbo_id is a framebuffer to attach the input to; it's left without an attachment
+inline bool vr_blit_texture(GLuint read_fbo_id,
+						   GLuint input_texture_id, GLenum input_target, const GLint input_dim[2],
+						   GLuint fbo_id, GLuint fbo_texture_id, const GLint fbo_dim[2],
+						   bool flipY) {
+	GLint previousReadFBO, previousDrawFBO;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING_EXT, &previousReadFBO);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING_EXT, &previousDrawFBO);
+	GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+
+	glBindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, read_fbo_id);
+	glFramebufferTexture2DEXT(GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, input_target, input_texture_id, 0);
+	glBindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, fbo_id);
+	glFramebufferTexture2DEXT(GL_DRAW_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, fbo_texture_id, 0);
+
+	bool complete = glCheckFramebufferStatusEXT(GL_READ_FRAMEBUFFER_EXT) == GL_FRAMEBUFFER_COMPLETE_EXT
+		&& glCheckFramebufferStatusEXT(GL_DRAW_FRAMEBUFFER_EXT) == GL_FRAMEBUFFER_COMPLETE_EXT;
+	if (complete) {
+		if (scissor) glDisable(GL_SCISSOR_TEST);
+		GLint w = fbo_dim[0], h = fbo_dim[1];
+		GLenum filter = (input_dim[0] == w && input_dim[1] == h) ? GL_NEAREST : GL_LINEAR;
+		glBlitFramebufferEXT(0, 0, input_dim[0], input_dim[1],
+			0, flipY ? h : 0, w, flipY ? 0 : h,
+			GL_COLOR_BUFFER_BIT, filter);
+		if (scissor) glEnable(GL_SCISSOR_TEST);
+	}
+
+	// detach the input, so that the read FBO doesn't keep a reference to a texture Jitter may delete
+	glFramebufferTexture2DEXT(GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, input_target, 0, 0);
+	glBindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, previousReadFBO);
+	glBindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, previousDrawFBO);
+	return complete;
+}
+
+// the input must be a GL_TEXTURE_RECTANGLE_ARB
+// returns the status of the destination framebuffer; only GL_FRAMEBUFFER_COMPLETE_EXT means it was copied
+inline GLenum vr_draw_texture(GLuint input_texture_id, const GLint input_dim[2],
+							 GLuint fbo_id, GLuint fbo_texture_id, const GLint fbo_dim[2],
+							 bool flipY) {
+	// save some state
+	GLint previousFBO;	// make sure we pop out to the right FBO
+	GLint previousMatrixMode;
+
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &previousFBO);
+	glGetIntegerv(GL_MATRIX_MODE, &previousMatrixMode);
+
+	// save texture state, client state, etc.
+	glPushAttrib(GL_ALL_ATTRIB_BITS);
+	glPushClientAttrib(GL_CLIENT_ALL_ATTRIB_BITS);
+
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo_id);
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, fbo_texture_id, 0);
+	GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+	if (status == GL_FRAMEBUFFER_COMPLETE_EXT) {
+		glMatrixMode(GL_TEXTURE);
+		glPushMatrix();
+		glLoadIdentity();
+
+		glViewport(0, 0, fbo_dim[0], fbo_dim[1]);
+
+		glMatrixMode(GL_PROJECTION);
+		glPushMatrix();
+		glLoadIdentity();
+		if (flipY) {
+			glOrtho(0.0, fbo_dim[0], 0.0, fbo_dim[1], -1, 1);
+		}
+		else {
+			glOrtho(0.0, fbo_dim[0], fbo_dim[1], 0., -1, 1);
+		}
+
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+		glLoadIdentity();
+
+		glClearColor(0, 0, 0, 1);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glActiveTexture(GL_TEXTURE0);
+		glClientActiveTexture(GL_TEXTURE0);
+		glEnable(GL_TEXTURE_RECTANGLE_ARB);
+		glBindTexture(GL_TEXTURE_RECTANGLE_ARB, input_texture_id);
+
+		// do not need blending if we use black border for alpha and replace env mode, saves a buffer wipe
+		// we can do this since our image draws over the complete surface of the FBO, no pixel goes untouched.
+
+		glDisable(GL_BLEND);
+		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+		// move to VA for rendering
+		GLfloat tex_coords[] = {
+			(GLfloat)input_dim[0], 0.f,
+			0.0, 0.f,
+			0.0, (GLfloat)input_dim[1],
+			(GLfloat)input_dim[0], (GLfloat)input_dim[1]
+		};
+
+		GLfloat verts[] = {
+			(GLfloat)fbo_dim[0], (GLfloat)fbo_dim[1],
+			0.0, (GLfloat)fbo_dim[1],
+			0.0, 0.0,
+			(GLfloat)fbo_dim[0], 0.0
+		};
+
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, 0, tex_coords);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glVertexPointer(2, GL_FLOAT, 0, verts);
+		glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+		glBindTexture(GL_TEXTURE_RECTANGLE_ARB, 0);
+
+		glMatrixMode(GL_MODELVIEW);
+		glPopMatrix();
+		glMatrixMode(GL_PROJECTION);
+		glPopMatrix();
+
+		glMatrixMode(GL_TEXTURE);
+		glPopMatrix();
+	}
+
+	// tidy up:
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+	glPopAttrib();
+	glPopClientAttrib();
+	glMatrixMode(previousMatrixMode);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, previousFBO);
+	return status;
+}
+
+#endif /* vr_copy_h */
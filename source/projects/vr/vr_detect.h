@@ -0,0 +1,93 @@
+#ifndef vr_detect_h
+#define vr_detect_h
+
+/*
+	Detecting which drivers have an HMD, without blocking Max's main thread.
+
+	ovr_Detect() can block for its whole timeout, and VR_IsHmdPresent() may have to load the runtime,
+	so detection runs in a background thread. The result is cached, with the time it was made,
+	and shared by every vr object in the process (so that a patch with several of them only detects once).
+
+	request() starts a detection unless one is already running, and returns at once.
+	When a detection finishes, the qelem of every subscriber is set, so that each object
+	picks up latest() in the main thread.
+
+	The detector is created on first use and never freed, so that a detection still running
+	when the last object is freed can finish safely.
+
+	Include after the Max headers (for qelem_set).
+*/
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+struct Availability {
+	bool oculus = false;
+	bool steam = false;
+	double time = -1.;	// when it was detected (AvailabilityDetector::now()); -1 if not yet
+};
+
+class AvailabilityDetector {
+public:
+
+	// runs in the detection thread
+	typedef void (*Detect)(Availability& result);
+
+	AvailabilityDetector(Detect detect) : mDetect(detect), mBusy(false) {}
+
+	void subscribe(void * qelem) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		mSubscribers.push_back(qelem);
+	}
+
+	// after this returns, the qelem won't be set again
+	void unsubscribe(void * qelem) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		mSubscribers.erase(std::remove(mSubscribers.begin(), mSubscribers.end(), qelem), mSubscribers.end());
+	}
+
+	void request() {
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mBusy) return; // its result will do
+		mBusy = true;
+		std::thread(&AvailabilityDetector::run, this).detach();
+	}
+
+	Availability latest() {
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mLatest;
+	}
+
+	// seconds since the latest detection, or -1 if there hasn't been one
+	double age() {
+		Availability a = latest();
+		return a.time < 0. ? -1. : now() - a.time;
+	}
+
+	static double now() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+protected:
+
+	void run() {
+		Availability result;
+		mDetect(result);
+		result.time = now();
+		std::lock_guard<std::mutex> lock(mMutex);
+		mLatest = result;
+		mBusy = false;
+		for (void * qelem : mSubscribers) qelem_set(qelem);
+	}
+
+	Detect mDetect;
+	std::mutex mMutex;
+	bool mBusy;	// guarded by mMutex, as are:
+	Availability mLatest;
+	std::vector<void *> mSubscribers;
+};
+
+#endif /* vr_detect_h */
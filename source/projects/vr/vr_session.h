@@ -0,0 +1,561 @@
+#ifndef vr_session_h
+#define vr_session_h
+
+/*
+	Binary recording of vr tracking sessions.
+
+	A session file holds one frame per bang(): the eye poses & frusta,
+	one row per tracked device (the same row layout as @tracking_format matrix),
+	plus each controller's raw input state as the driver reported it (see SESSION_INPUT_*),
+	and any driver events received during that frame, with their age & data payload.
+
+	File layout:
+		header:		"VRSESS02", u32 columns per device row
+		frames:		(see SessionWriter::encode)
+		index:		u32 count, then per keyframe: u32 frame number, f64 time, u64 file offset
+		trailer:	u64 index offset, "VRSESEND"
+
+	Frames store each float as the XOR of its bits with the same value in the previous frame,
+	written as a varint, so unchanged values cost one byte and slowly changing values only a few.
+	Every SESSION_KEYFRAME_INTERVAL frames is a keyframe (XOR against zero, all device names included),
+	so that a reader can seek to any keyframe listed in the index.
+
+	SessionWriter::write() is called from the main thread and never blocks:
+	frames are encoded into one of two memory blocks, and a writer thread
+	flushes full blocks to disk. If both blocks are full, the frame is dropped (and counted).
+
+	SessionReader memory-maps a session file and decodes it frame by frame.
+	A file without an index (e.g. if recording was interrupted) can still be played from the start.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#define SESSION_MAGIC "VRSESS02"
+#define SESSION_END_MAGIC "VRSESEND"
+#define SESSION_MAX_DEVICES 64
+#define SESSION_MAX_EVENTS 32
+#define SESSION_MAX_COLUMNS 32
+#define SESSION_EYE_FLOATS 13 // position xyz, quat xyzw, frustum left right bottom top near far
+#define SESSION_KEYFRAME_INTERVAL 90
+#define SESSION_BLOCK_SIZE (1 << 18)
+#define SESSION_EVENT_DATA 24 // bytes of event payload (the size of vr::VREvent_Data_t)
+
+// a controller's raw input, stored as words (floats by their bits):
+#define SESSION_INPUT_PACKET 0		// SteamVR unPacketNum
+#define SESSION_INPUT_PRESSED 1		// 64-bit button mask, low word first: SteamVR ulButtonPressed, Oculus Buttons
+#define SESSION_INPUT_TOUCHED 3		// likewise: SteamVR ulButtonTouched, Oculus Touches
+#define SESSION_INPUT_AXES 5		// 6 x (x, y): SteamVR rAxis[0..4]; Oculus, for its hand: Thumbstick, (IndexTrigger, HandTrigger),
+									// then both again with no deadzone, then raw
+#define SESSION_INPUT_WORDS 17
+
+struct SessionDevice {
+	uint32_t index;
+	const char * name;
+	float row[SESSION_MAX_COLUMNS];
+	bool has_input;		// false for devices without controller input
+	uint32_t input[SESSION_INPUT_WORDS];
+};
+
+// a driver event, as received (e.g. vr::VREvent_t)
+struct SessionEvent {
+	uint32_t type;
+	uint32_t device;
+	float age;		// seconds before it was received
+	unsigned char data[SESSION_EVENT_DATA];
+};
+
+struct SessionFrame {
+	double time;	// seconds since recording started
+	float eyes[2][SESSION_EYE_FLOATS];
+	int numdevices;
+	SessionDevice devices[SESSION_MAX_DEVICES];
+	int numevents;
+	SessionEvent events[SESSION_MAX_EVENTS];
+};
+
+struct SessionIndexEntry {
+	uint32_t frame;
+	double time;
+	uint64_t offset;
+};
+
+// XOR-delta + varint coding shared by writer & reader
+struct SessionCodec {
+
+	static uint32_t float_bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+	static float bits_float(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+	static unsigned char * put_varint(unsigned char * p, uint64_t v) {
+		while (v >= 0x80) {
+			*p++ = (unsigned char)(v | 0x80);
+			v >>= 7;
+		}
+		*p++ = (unsigned char)v;
+		return p;
+	}
+
+	// returns null on overrun
+	static const unsigned char * get_varint(const unsigned char * p, const unsigned char * end, uint64_t& v) {
+		v = 0;
+		for (int shift = 0; p < end && shift < 64; shift += 7) {
+			unsigned char b = *p++;
+			v |= uint64_t(b & 0x7f) << shift;
+			if (!(b & 0x80)) return p;
+		}
+		return 0;
+	}
+
+	static unsigned char * put_words(unsigned char * p, const uint32_t * v, uint32_t * prev, int n) {
+		for (int i = 0; i < n; i++) {
+			p = put_varint(p, v[i] ^ prev[i]);
+			prev[i] = v[i];
+		}
+		return p;
+	}
+
+	static const unsigned char * get_words(const unsigned char * p, const unsigned char * end, uint32_t * v, uint32_t * prev, int n) {
+		for (int i = 0; i < n && p; i++) {
+			uint64_t x;
+			p = get_varint(p, end, x);
+			v[i] = prev[i] = uint32_t(x) ^ prev[i];
+		}
+		return p;
+	}
+
+	static unsigned char * put_floats(unsigned char * p, const float * v, float * prev, int n) {
+		for (int i = 0; i < n; i++) {
+			p = put_varint(p, float_bits(v[i]) ^ float_bits(prev[i]));
+			prev[i] = v[i];
+		}
+		return p;
+	}
+
+	static const unsigned char * get_floats(const unsigned char * p, const unsigned char * end, float * v, float * prev, int n) {
+		for (int i = 0; i < n && p; i++) {
+			uint64_t x;
+			p = get_varint(p, end, x);
+			v[i] = prev[i] = bits_float(uint32_t(x) ^ float_bits(prev[i]));
+		}
+		return p;
+	}
+};
+
+class SessionWriter {
+public:
+
+	// upper bound on the encoded size of one frame
+	static const size_t MAX_FRAME_BYTES = 16 + 2 * SESSION_EYE_FLOATS * 5 + 5
+		+ SESSION_MAX_DEVICES * (5 + 1 + 5 + 255 + SESSION_MAX_COLUMNS * 5 + 1 + SESSION_INPUT_WORDS * 5)
+		+ 5 + SESSION_MAX_EVENTS * (10 + 5 + SESSION_EVENT_DATA / 4 * 5);
+
+	SessionWriter() : mFull(-1), mRunning(false), mDropped(0) {}
+	~SessionWriter() { close(); }
+
+	bool is_open() const { return mFile != 0; }
+	uint32_t dropped() const { return mDropped; }
+	uint32_t frames() const { return mFrame; }
+
+	bool open(const char * path, int columns) {
+		close();
+		if (columns > SESSION_MAX_COLUMNS) return false;
+		mFile = fopen(path, "wb");
+		if (!mFile) return false;
+		mColumns = columns;
+		mFrame = 0;
+		mDropped = 0;
+		mBlockOffset = 0;
+		mIndex.clear();
+		mIndex.reserve(1024);
+		for (int b = 0; b < 2; b++) {
+			mBlocks[b].resize(SESSION_BLOCK_SIZE);
+			mFill[b] = 0;
+		}
+		mCurrent = 0;
+		mFull = -1;
+
+		unsigned char header[12];
+		memcpy(header, SESSION_MAGIC, 8);
+		uint32_t c = columns;
+		memcpy(header + 8, &c, 4);
+		fwrite(header, 1, sizeof(header), mFile);
+		mBlockOffset = sizeof(header);
+
+		mRunning = true;
+		mThread = std::thread(&SessionWriter::run, this);
+		return true;
+	}
+
+	// main thread; never blocks
+	// returns false if the frame had to be dropped
+	bool write(SessionFrame const & frame) {
+		if (!mFile) return false;
+
+		if (SESSION_BLOCK_SIZE - mFill[mCurrent] < MAX_FRAME_BYTES) {
+			// hand the current block to the writer thread, if it is free
+			if (mFull.load(std::memory_order_acquire) != -1) {
+				mDropped++;
+				return false;
+			}
+			// the next block starts where this one will end in the file, whenever the writer gets to it:
+			mBlockOffset += mFill[mCurrent];
+			mFull.store(mCurrent, std::memory_order_release);
+			// notify without taking the lock; a missed wakeup only costs the writer's timeout
+			mWake.notify_one();
+			mCurrent = !mCurrent;
+			mFill[mCurrent] = 0;
+		}
+
+		bool key = (mFrame % SESSION_KEYFRAME_INTERVAL) == 0;
+		if (key) {
+			// keyframes are coded against zero:
+			memset(mPrevEyes, 0, sizeof(mPrevEyes));
+			memset(mPrevRows, 0, sizeof(mPrevRows));
+			memset(mPrevInputs, 0, sizeof(mPrevInputs));
+			for (int i = 0; i < SESSION_MAX_DEVICES; i++) mPrevNames[i] = 0;
+			SessionIndexEntry e = { mFrame, frame.time, mBlockOffset + mFill[mCurrent] };
+			mIndex.push_back(e);
+		}
+		unsigned char * start = &mBlocks[mCurrent][mFill[mCurrent]];
+		unsigned char * end = encode(start, frame, key);
+		mFill[mCurrent] += end - start;
+		mFrame++;
+		return true;
+	}
+
+	// main thread; waits for the writer thread to finish, then writes the index
+	void close() {
+		if (!mFile) return;
+		mRunning = false;
+		mWake.notify_one();
+		if (mThread.joinable()) mThread.join();
+		uint64_t index_offset = mBlockOffset + mFill[mCurrent];
+		flush(mCurrent);
+
+		uint32_t count = (uint32_t)mIndex.size();
+		fwrite(&count, 4, 1, mFile);
+		for (auto& e : mIndex) {
+			fwrite(&e.frame, 4, 1, mFile);
+			fwrite(&e.time, 8, 1, mFile);
+			fwrite(&e.offset, 8, 1, mFile);
+		}
+		fwrite(&index_offset, 8, 1, mFile);
+		fwrite(SESSION_END_MAGIC, 1, 8, mFile);
+		fclose(mFile);
+		mFile = 0;
+	}
+
+protected:
+
+	unsigned char * encode(unsigned char * p, SessionFrame const & frame, bool key) {
+		*p++ = key ? 1 : 2;
+		memcpy(p, &frame.time, 8); p += 8;
+		p = SessionCodec::put_floats(p, &frame.eyes[0][0], &mPrevEyes[0][0], 2 * SESSION_EYE_FLOATS);
+
+		p = SessionCodec::put_varint(p, frame.numdevices);
+		for (int i = 0; i < frame.numdevices; i++) {
+			const SessionDevice& dev = frame.devices[i];
+			uint32_t index = dev.index % SESSION_MAX_DEVICES;
+			p = SessionCodec::put_varint(p, index);
+			// names are only written when they change (compared by pointer, as they are interned symbols):
+			if (dev.name != mPrevNames[index]) {
+				size_t len = dev.name ? strlen(dev.name) : 0;
+				if (len > 255) len = 255;
+				*p++ = (unsigned char)(len + 1);
+				memcpy(p, dev.name, len); p += len;
+				mPrevNames[index] = dev.name;
+			}
+			else {
+				*p++ = 0;
+			}
+			p = SessionCodec::put_floats(p, dev.row, mPrevRows[index], mColumns);
+			*p++ = dev.has_input ? 1 : 0;
+			if (dev.has_input) p = SessionCodec::put_words(p, dev.input, mPrevInputs[index], SESSION_INPUT_WORDS);
+		}
+
+		// event data is coded against zero, as most of it is unused:
+		p = SessionCodec::put_varint(p, frame.numevents);
+		for (int i = 0; i < frame.numevents; i++) {
+			const SessionEvent& event = frame.events[i];
+			uint32_t data[SESSION_EVENT_DATA / 4], zero[SESSION_EVENT_DATA / 4] = { 0 };
+			memcpy(data, event.data, SESSION_EVENT_DATA);
+			p = SessionCodec::put_varint(p, event.type);
+			p = SessionCodec::put_varint(p, event.device);
+			p = SessionCodec::put_varint(p, SessionCodec::float_bits(event.age));
+			p = SessionCodec::put_words(p, data, zero, SESSION_EVENT_DATA / 4);
+		}
+		return p;
+	}
+
+	void flush(int b) {
+		if (mFill[b]) {
+			fwrite(&mBlocks[b][0], 1, mFill[b], mFile);
+			mFill[b] = 0;
+		}
+	}
+
+	// writer thread
+	void run() {
+		while (mRunning) {
+			int b = mFull.load(std::memory_order_acquire);
+			if (b != -1) {
+				flush(b);
+				mFull.store(-1, std::memory_order_release);
+			}
+			else {
+				std::unique_lock<std::mutex> lock(mWakeMutex);
+				mWake.wait_for(lock, std::chrono::milliseconds(2));
+			}
+		}
+		// any block still queued:
+		int b = mFull.load(std::memory_order_acquire);
+		if (b != -1) {
+			flush(b);
+			mFull.store(-1, std::memory_order_release);
+		}
+	}
+
+	FILE * mFile = 0;
+	int mColumns = 0;
+	uint32_t mFrame = 0;
+	// file offset that the current block will be written at; only the main thread uses it,
+	// so that keyframe offsets don't depend on how far the writer thread has got
+	uint64_t mBlockOffset = 0;
+
+	std::vector<unsigned char> mBlocks[2];
+	size_t mFill[2];
+	int mCurrent = 0;				// block being filled by the main thread
+	std::atomic<int> mFull;			// block waiting for the writer thread, or -1
+	std::atomic<bool> mRunning;
+	std::atomic<uint32_t> mDropped;
+	std::thread mThread;
+	std::mutex mWakeMutex;	// only ever locked by the writer thread
+	std::condition_variable mWake;
+
+	std::vector<SessionIndexEntry> mIndex;
+	float mPrevEyes[2][SESSION_EYE_FLOATS];
+	float mPrevRows[SESSION_MAX_DEVICES][SESSION_MAX_COLUMNS];
+	uint32_t mPrevInputs[SESSION_MAX_DEVICES][SESSION_INPUT_WORDS];
+	const char * mPrevNames[SESSION_MAX_DEVICES];
+};
+
+class SessionReader {
+public:
+
+	~SessionReader() { close(); }
+
+	bool is_open() const { return mData != 0; }
+	int columns() const { return mColumns; }
+	std::vector<SessionIndexEntry> const & index() const { return mIndex; }
+
+	bool open(const char * path) {
+		close();
+		if (!map(path)) return false;
+
+		uint32_t columns = 0;
+		if (mSize < 12 || memcmp(mData, SESSION_MAGIC, 8) != 0) { close(); return false; }
+		memcpy(&columns, mData + 8, 4);
+		if (columns > SESSION_MAX_COLUMNS) { close(); return false; }
+		mColumns = columns;
+		mBegin = mData + 12;
+		mEnd = mData + mSize;
+
+		// the index, if the recording was closed properly:
+		if (mSize >= 12 + 4 + 16 && memcmp(mData + mSize - 8, SESSION_END_MAGIC, 8) == 0) {
+			uint64_t index_offset;
+			memcpy(&index_offset, mData + mSize - 16, 8);
+			if (index_offset >= 12 && index_offset + 4 <= mSize - 16) {
+				const unsigned char * p = mData + index_offset;
+				uint32_t count;
+				memcpy(&count, p, 4); p += 4;
+				if (count <= (mSize - 16 - index_offset - 4) / 20) {
+					mIndex.resize(count);
+					for (auto& e : mIndex) {
+						memcpy(&e.frame, p, 4); p += 4;
+						memcpy(&e.time, p, 8); p += 8;
+						memcpy(&e.offset, p, 8); p += 8;
+					}
+					mEnd = mData + index_offset;
+				}
+			}
+		}
+		rewind();
+		return true;
+	}
+
+	void close() {
+		unmap();
+		mIndex.clear();
+		mBegin = mEnd = mPos = 0;
+	}
+
+	void rewind() { mPos = mBegin; }
+
+	bool at_end() const { return mPos >= mEnd; }
+
+	// time of the next frame, without decoding it
+	bool peek_time(double& t) const {
+		if (mEnd - mPos < 9) return false;
+		memcpy(&t, mPos + 1, 8);
+		return true;
+	}
+
+	// decode the next frame
+	// returns false at the end of the file, or if the data is corrupt
+	bool next(SessionFrame& frame) {
+		const unsigned char * p = mPos;
+		const unsigned char * end = mEnd;
+		if (end - p < 9) return false;
+
+		unsigned char tag = *p++;
+		if (tag == 1) {
+			memset(mPrevEyes, 0, sizeof(mPrevEyes));
+			memset(mPrevRows, 0, sizeof(mPrevRows));
+			memset(mPrevInputs, 0, sizeof(mPrevInputs));
+			for (int i = 0; i < SESSION_MAX_DEVICES; i++) mNames[i].clear();
+		}
+		else if (tag != 2) return false;
+		memcpy(&frame.time, p, 8); p += 8;
+		p = SessionCodec::get_floats(p, end, &frame.eyes[0][0], &mPrevEyes[0][0], 2 * SESSION_EYE_FLOATS);
+
+		uint64_t v;
+		if (!p || !(p = SessionCodec::get_varint(p, end, v)) || v > SESSION_MAX_DEVICES) return false;
+		frame.numdevices = (int)v;
+		for (int i = 0; i < frame.numdevices; i++) {
+			SessionDevice& dev = frame.devices[i];
+			if (!(p = SessionCodec::get_varint(p, end, v)) || v >= SESSION_MAX_DEVICES || p >= end) return false;
+			dev.index = (uint32_t)v;
+			size_t len = *p++;
+			if (len) {
+				len--;
+				if (size_t(end - p) < len) return false;
+				mNames[dev.index].assign((const char *)p, len);
+				p += len;
+			}
+			dev.name = mNames[dev.index].c_str();
+			p = SessionCodec::get_floats(p, end, dev.row, mPrevRows[dev.index], mColumns);
+			if (!p) return false;
+			for (int c = mColumns; c < SESSION_MAX_COLUMNS; c++) dev.row[c] = 0.f;
+			if (p >= end) return false;
+			dev.has_input = *p++ != 0;
+			if (dev.has_input) {
+				if (!(p = SessionCodec::get_words(p, end, dev.input, mPrevInputs[dev.index], SESSION_INPUT_WORDS))) return false;
+			}
+			else {
+				memset(dev.input, 0, sizeof(dev.input));
+			}
+		}
+
+		if (!(p = SessionCodec::get_varint(p, end, v))) return false;
+		int numevents = (int)v;
+		frame.numevents = 0;
+		for (int i = 0; i < numevents; i++) {
+			uint64_t type, device, age;
+			uint32_t data[SESSION_EVENT_DATA / 4], zero[SESSION_EVENT_DATA / 4] = { 0 };
+			if (!(p = SessionCodec::get_varint(p, end, type)) || !(p = SessionCodec::get_varint(p, end, device))
+				|| !(p = SessionCodec::get_varint(p, end, age))
+				|| !(p = SessionCodec::get_words(p, end, data, zero, SESSION_EVENT_DATA / 4))) return false;
+			if (frame.numevents < SESSION_MAX_EVENTS) {
+				SessionEvent& event = frame.events[frame.numevents++];
+				event.type = (uint32_t)type;
+				event.device = (uint32_t)device;
+				event.age = SessionCodec::bits_float((uint32_t)age);
+				memcpy(event.data, data, SESSION_EVENT_DATA);
+			}
+		}
+		mPos = p;
+		return true;
+	}
+
+	// decode up to the last frame at or before time t, starting from the nearest keyframe
+	// (events of the skipped frames are discarded)
+	bool seek(double t, SessionFrame& frame) {
+		mPos = mBegin;
+		for (auto& e : mIndex) {
+			if (e.time > t) break;
+			if (e.offset < uint64_t(mEnd - mData)) mPos = mData + e.offset;
+		}
+		if (!next(frame)) return false;
+		double ft;
+		while (peek_time(ft) && ft <= t && next(frame)) {}
+		return true;
+	}
+
+protected:
+
+	bool map(const char * path) {
+#ifdef _WIN32
+		mFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (mFile == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0) { unmap(); return false; }
+		mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!mMapping) { unmap(); return false; }
+		mData = (const unsigned char *)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+		if (!mData) { unmap(); return false; }
+		mSize = (size_t)size.QuadPart;
+#else
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+		void * data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (data == MAP_FAILED) return false;
+		madvise(data, st.st_size, MADV_SEQUENTIAL);
+		mData = (const unsigned char *)data;
+		mSize = st.st_size;
+#endif
+		return true;
+	}
+
+	void unmap() {
+#ifdef _WIN32
+		if (mData) UnmapViewOfFile(mData);
+		if (mMapping) CloseHandle(mMapping);
+		if (mFile != INVALID_HANDLE_VALUE) CloseHandle(mFile);
+		mMapping = 0;
+		mFile = INVALID_HANDLE_VALUE;
+#else
+		if (mData) munmap((void *)mData, mSize);
+#endif
+		mData = 0;
+		mSize = 0;
+	}
+
+#ifdef _WIN32
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = 0;
+#endif
+	const unsigned char * mData = 0;
+	size_t mSize = 0;
+	const unsigned char * mBegin = 0;
+	const unsigned char * mEnd = 0; // end of the frame data (start of the index)
+	const unsigned char * mPos = 0;
+	int mColumns = 0;
+
+	std::vector<SessionIndexEntry> mIndex;
+	float mPrevEyes[2][SESSION_EYE_FLOATS];
+	float mPrevRows[SESSION_MAX_DEVICES][SESSION_MAX_COLUMNS];
+	uint32_t mPrevInputs[SESSION_MAX_DEVICES][SESSION_INPUT_WORDS];
+	std::string mNames[SESSION_MAX_DEVICES];
+};
+
+#endif /* vr_session_h */
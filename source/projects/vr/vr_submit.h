@@ -0,0 +1,218 @@
+#ifndef vr_submit_h
+#define vr_submit_h
+
+/*
+	Handing frames to the compositor from a worker thread.
+
+	The compositor calls (VRCompositor()->Submit, ovr_SubmitFrame) can block for a good part of a frame,
+	e.g. until a swap chain buffer is free. SubmitWorker makes them on its own thread instead, so that
+	the main thread only fences the GL commands that produced a frame, and queues it.
+
+	The worker has its own GL context, sharing objects with the context that was current when start() was called
+	(i.e. Jitter's). For each frame it waits for the fence, calls the handler, and flushes, so a fence made by the
+	handler is visible to other contexts once the handler returns. Frames are handled in order.
+	A frame counts towards depth() until its handler has returned; push() waits while the queue is full.
+
+	Jobs are copied into a fixed ring, so nothing is allocated per frame.
+
+	Include after the jit.gl headers (for the GL types and sync functions).
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef __APPLE__
+	#include <OpenGL/OpenGL.h>
+#endif
+
+#include "al_perf.h"
+
+#define SUBMIT_QUEUE_DEPTH (2)
+#define SUBMIT_FENCE_WAIT_NS (100000000ull) // give up on a fence after 100ms
+
+// a GL context for another thread, sharing objects with the current one
+struct SubmitContext {
+#if defined(_WIN32)
+	HDC dc = 0;
+	HGLRC context = 0;
+
+	bool create() {
+		HGLRC current = wglGetCurrentContext();
+		dc = wglGetCurrentDC();
+		if (!current || !dc) return false;
+		context = wglCreateContext(dc);
+		if (context && !wglShareLists(current, context)) destroy();
+		return context != 0;
+	}
+
+	bool make_current() { return wglMakeCurrent(dc, context) != 0; }
+	void release_current() { wglMakeCurrent(0, 0); }
+
+	void destroy() {
+		if (context) wglDeleteContext(context);
+		context = 0;
+		dc = 0;
+	}
+#elif defined(__APPLE__)
+	CGLContextObj context = 0;
+
+	bool create() {
+		CGLContextObj current = CGLGetCurrentContext();
+		if (!current) return false;
+		if (CGLCreateContext(CGLGetPixelFormat(current), current, &context) != kCGLNoError) context = 0;
+		return context != 0;
+	}
+
+	bool make_current() { return CGLSetCurrentContext(context) == kCGLNoError; }
+	void release_current() { CGLSetCurrentContext(0); }
+
+	void destroy() {
+		if (context) CGLDestroyContext(context);
+		context = 0;
+	}
+#else
+	bool create() { return false; }
+	bool make_current() { return false; }
+	void release_current() {}
+	void destroy() {}
+#endif
+};
+
+template<typename Job>
+class SubmitWorker {
+public:
+
+	// called in the worker thread, with its context current
+	typedef void (*Handler)(void * owner, Job& job);
+
+	SubmitWorker() : mRunning(false), mHead(0), mTail(0), mWaitTime(0.) {}
+	~SubmitWorker() { stop(); }
+
+	bool is_running() const { return mRunning; }
+
+	// call with the context to share current
+	// stage (if given) records, per frame, the worker's time waiting for the fence and in the handler
+	bool start(void * owner, Handler handler, PerfStage * stage = 0) {
+		stop();
+		if (!mContext.create()) return false;
+		mOwner = owner;
+		mHandler = handler;
+		mStage = stage;
+		mHead = mTail = 0;
+		mWaitTime = 0.;
+		mRunning = true;
+		mThread = std::thread(&SubmitWorker::run, this);
+		return true;
+	}
+
+	// handles any frames still queued, then stops
+	void stop() {
+		if (!mThread.joinable()) return;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mRunning = false;
+		}
+		mWake.notify_all();
+		mThread.join();
+		mContext.destroy();
+		// frames left if the worker couldn't use its context:
+		for (; mHead != mTail; mHead++) glDeleteSync(mFences[mHead % SUBMIT_QUEUE_DEPTH]);
+	}
+
+	// queue a frame, to be handled once the GPU has passed fence (push takes ownership of it)
+	// returns false (leaving the fence to the caller) if the worker isn't running
+	// waited is set if the queue was full
+	bool push(Job const& job, GLsync fence, bool& waited) {
+		std::unique_lock<std::mutex> lock(mMutex);
+		waited = mRunning && mTail - mHead >= SUBMIT_QUEUE_DEPTH;
+		mDone.wait(lock, [this] { return !mRunning || mTail - mHead < SUBMIT_QUEUE_DEPTH; });
+		if (!mRunning) return false;
+		mJobs[mTail % SUBMIT_QUEUE_DEPTH] = job;
+		mFences[mTail % SUBMIT_QUEUE_DEPTH] = fence;
+		mTail++;
+		lock.unlock();
+		mWake.notify_one();
+		return true;
+	}
+
+	// wait until every queued frame has been handled
+	// returns whether there were any
+	bool wait_idle() {
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mHead == mTail) return false;
+		mDone.wait(lock, [this] { return mHead == mTail; });
+		return true;
+	}
+
+	// frames queued or being handled
+	int depth() {
+		std::lock_guard<std::mutex> lock(mMutex);
+		return int(mTail - mHead);
+	}
+
+	// smoothed ms per frame the worker waited on the fence and in the handler
+	double wait_time() const { return mWaitTime; }
+
+protected:
+
+	void run() {
+		if (!mContext.make_current()) {
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mRunning = false;
+			}
+			mDone.notify_all();
+			return;
+		}
+		for (;;) {
+			Job job;
+			GLsync fence;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWake.wait(lock, [this] { return !mRunning || mHead != mTail; });
+				if (mHead == mTail) break; // stopped, and nothing left to handle
+				job = mJobs[mHead % SUBMIT_QUEUE_DEPTH];
+				fence = mFences[mHead % SUBMIT_QUEUE_DEPTH];
+			}
+
+			double t0 = PerfStage::now();
+			if (fence) {
+				glClientWaitSync(fence, 0, SUBMIT_FENCE_WAIT_NS);
+				glDeleteSync(fence);
+			}
+			mHandler(mOwner, job);
+			glFlush();
+			double ms = 1000. * (PerfStage::now() - t0);
+			if (mStage) mStage->record(ms);
+			double w = mWaitTime;
+			mWaitTime = (w <= 0.) ? ms : w + 0.1 * (ms - w);
+
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mHead++;
+			}
+			mDone.notify_all();
+		}
+		mContext.release_current();
+	}
+
+	SubmitContext mContext;
+	std::thread mThread;
+	std::mutex mMutex;
+	std::condition_variable mWake;	// the worker waits for a frame (or stop)
+	std::condition_variable mDone;	// push() and wait_idle() wait for a frame to be handled
+	std::atomic<bool> mRunning;
+	void * mOwner = 0;
+	Handler mHandler = 0;
+	PerfStage * mStage = 0;
+
+	Job mJobs[SUBMIT_QUEUE_DEPTH];
+	GLsync mFences[SUBMIT_QUEUE_DEPTH];
+	uint32_t mHead, mTail;	// guarded by mMutex
+	std::atomic<double> mWaitTime;
+};
+
+#endif /* vr_submit_h */
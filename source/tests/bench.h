@@ -0,0 +1,33 @@
+#ifndef bench_h
+#define bench_h
+
+/*
+	Timing for the bench_* programs.
+
+	bench_ns() runs f over and over, and returns the fastest of several rounds, in ns per call,
+	so that a round disturbed by the rest of the system doesn't count.
+	Results should be fed into bench_sink, so that the compiler can't drop the work.
+*/
+
+#include <chrono>
+#include <cstdio>
+
+static volatile float bench_sink = 0.f;
+
+template<typename F>
+double bench_ns(F f, int calls, int rounds = 9) {
+	double best = 0.;
+	for (int r = 0; r < rounds; r++) {
+		auto t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < calls; i++) f();
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / calls;
+		if (r == 0 || ns < best) best = ns;
+	}
+	return best;
+}
+
+static void bench_report(const char * name, double before_ns, double after_ns, const char * unit = "call") {
+	printf("%-28s before %9.1f ns/%s   after %9.1f ns/%s   (x%.2f)\n", name, before_ns, unit, after_ns, unit, before_ns / after_ns);
+}
+
+#endif /* bench_h */
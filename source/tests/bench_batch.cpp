@@ -0,0 +1,94 @@
+// cost of moving a frame of SteamVR device poses & velocities into world space:
+// before, one device at a time (HmdMatrix34_t -> mat4 -> Pose, view_pose * pose, two rotates),
+// after, with the PoseBatch & Vec3Batch kernels (al_math.h) over the whole array at once
+// built twice: bench_batch uses whichever SIMD the compiler targets, bench_batch_scalar the scalar fallback
+// also checks that both ways agree
+
+#include <cmath>
+
+#include "al_math.h"
+#include "bench.h"
+
+#define BENCH_DEVICES (16)	// vr::k_unMaxTrackedDeviceCount in the vendored OpenVR
+#define BENCH_FRAMES (20000)
+
+// the layout of vr::TrackedDevicePose_t
+struct DevicePose {
+	float mDeviceToAbsoluteTracking[3][4];
+	float vVelocity[3];
+	float vAngularVelocity[3];
+	int eTrackingResult;
+	bool bPoseIsValid;
+	bool bDeviceIsConnected;
+};
+
+static DevicePose devices[BENCH_DEVICES];
+static PoseBatch poses, world_poses;
+static Vec3Batch world_velocities, world_angular_velocities;
+static Pose ref_world[BENCH_DEVICES];
+static glm::vec3 ref_vel[BENCH_DEVICES], ref_angvel[BENCH_DEVICES];
+
+static Pose to_pose(const float m[3][4]) {
+	return Pose::from_mat4(glm::mat4(
+		m[0][0], m[1][0], m[2][0], 0.0,
+		m[0][1], m[1][1], m[2][1], 0.0,
+		m[0][2], m[1][2], m[2][2], 0.0,
+		m[0][3], m[1][3], m[2][3], 1.0f));
+}
+
+int main() {
+	for (int i = 0; i < BENCH_DEVICES; i++) {
+		glm::vec3 axis = glm::normalize(glm::vec3(sinf(i * 1.3f), cosf(i * 0.7f), 0.5f));
+		// all the way round, so that each branch of the matrix to quat conversion is taken:
+		glm::mat4 m = glm::translate(glm::mat4(1.f), glm::vec3(0.1f * i, 1.5f, -0.2f * i)) * glm::mat4_cast(glm::angleAxis(0.4f * i, axis));
+		for (int r = 0; r < 3; r++) for (int c = 0; c < 4; c++) devices[i].mDeviceToAbsoluteTracking[r][c] = m[c][r];
+		for (int k = 0; k < 3; k++) {
+			devices[i].vVelocity[k] = 0.1f * (i + k);
+			devices[i].vAngularVelocity[k] = 0.2f * (i - k);
+		}
+	}
+	Pose view_pose(glm::normalize(glm::quat(0.9f, 0.1f, 0.4f, 0.1f)), glm::vec3(1.f, 0.f, -2.f));
+
+	// as steam_output_tracked_device() did:
+	double before = bench_ns([&] {
+		for (int i = 0; i < BENCH_DEVICES; i++) {
+			Pose pose = to_pose(devices[i].mDeviceToAbsoluteTracking);
+			ref_world[i] = view_pose * pose;
+			ref_vel[i] = view_pose.rotate(glm::vec3(devices[i].vVelocity[0], devices[i].vVelocity[1], devices[i].vVelocity[2]));
+			ref_angvel[i] = view_pose.rotate(glm::vec3(devices[i].vAngularVelocity[0], devices[i].vAngularVelocity[1], devices[i].vAngularVelocity[2]));
+		}
+		bench_sink = ref_world[BENCH_DEVICES - 1].quat.w;
+	}, BENCH_FRAMES);
+
+	// as steam_bang() does now:
+	double after = bench_ns([&] {
+		const size_t stride = sizeof(DevicePose);
+		poses.from_mat34(&devices[0].mDeviceToAbsoluteTracking, stride, BENCH_DEVICES);
+		world_poses = poses;
+		world_poses.premultiply(view_pose, BENCH_DEVICES);
+		world_velocities.gather(&devices[0].vVelocity, stride, BENCH_DEVICES);
+		world_velocities.rotate(view_pose.quat, BENCH_DEVICES);
+		world_angular_velocities.gather(&devices[0].vAngularVelocity, stride, BENCH_DEVICES);
+		world_angular_velocities.rotate(view_pose.quat, BENCH_DEVICES);
+		bench_sink = world_poses.qw[BENCH_DEVICES - 1];
+	}, BENCH_FRAMES);
+
+#ifdef AL_BATCH_LANES
+	printf("%d lanes\n", AL_BATCH_LANES);
+#else
+	printf("scalar\n");
+#endif
+	bench_report("world poses & velocities", before, after, "frame");
+
+	// the quats may differ in sign, which is the same rotation:
+	float err = 0.f;
+	for (int i = 0; i < BENCH_DEVICES; i++) {
+		Pose w = world_poses.get(i);
+		err = AL_MAX(err, 1.f - fabsf(glm::dot(w.quat, ref_world[i].quat)));
+		err = AL_MAX(err, glm::length(w.position - ref_world[i].position));
+		err = AL_MAX(err, glm::length(world_velocities.get(i) - ref_vel[i]));
+		err = AL_MAX(err, glm::length(world_angular_velocities.get(i) - ref_angvel[i]));
+	}
+	printf("largest difference from the per-device results: %g\n", err);
+	return err < 1e-4f ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+// CPU cost of copying a (rectangle) texture into a driver texture, as fbo_copy_texture does:
+// before, the fixed-function quad saving all state (vr_draw_texture), after, the framebuffer blit (vr_blit_texture)
+// runs headless, in an EGL surfaceless context (e.g. Mesa llvmpipe)
+// also checks that both copies produce the same pixels, flipped and not, and that the blit leaves GL state alone
+
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "vr_copy.h"
+#include "bench.h"
+
+#define BENCH_CALLS (200)
+
+static const GLint input_dim[2] = { 1024, 512 };
+static const GLint fbo_dim[2] = { 1024, 512 };
+
+static bool make_context() {
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	EGLDisplay display = get_display ? get_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0) : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	EGLint major, minor;
+	if (!eglInitialize(display, &major, &minor)) return false;
+	if (!eglBindAPI(EGL_OPENGL_API)) return false;
+	EGLint attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = 0;
+	EGLint count = 0;
+	eglChooseConfig(display, attribs, &config, 1, &count);
+	EGLContext context = eglCreateContext(display, count ? config : 0, EGL_NO_CONTEXT, 0);
+	return context != EGL_NO_CONTEXT && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+}
+
+static GLuint make_texture(GLenum target, const GLint dim[2], const void * pixels) {
+	GLuint tex;
+	glGenTextures(1, &tex);
+	glBindTexture(target, tex);
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(target, 0, GL_RGBA8, dim[0], dim[1], 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(target, 0);
+	return tex;
+}
+
+static std::vector<unsigned char> read_texture(GLuint fbo, GLuint tex, const GLint dim[2]) {
+	std::vector<unsigned char> pixels(dim[0] * dim[1] * 4);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo);
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, tex, 0);
+	glReadPixels(0, 0, dim[0], dim[1], GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+	return pixels;
+}
+
+int main() {
+	if (!make_context()) {
+		printf("no EGL context\n");
+		return 1;
+	}
+	printf("%s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	// every row & column different, so that a wrong flip or offset shows:
+	std::vector<unsigned char> pixels(input_dim[0] * input_dim[1] * 4);
+	for (int y = 0; y < input_dim[1]; y++) {
+		for (int x = 0; x < input_dim[0]; x++) {
+			unsigned char * p = &pixels[(y * input_dim[0] + x) * 4];
+			p[0] = (unsigned char)x; p[1] = (unsigned char)y; p[2] = (unsigned char)(x >> 8 | (y >> 8) << 4); p[3] = 255;
+		}
+	}
+	GLuint input = make_texture(GL_TEXTURE_RECTANGLE_ARB, input_dim, pixels.data());
+	GLuint output = make_texture(GL_TEXTURE_2D, fbo_dim, 0);
+	GLuint fbo, read_fbo, check_fbo;
+	glGenFramebuffersEXT(1, &fbo);
+	glGenFramebuffersEXT(1, &read_fbo);
+	glGenFramebuffersEXT(1, &check_fbo);
+
+	int failures = 0;
+	for (int flip = 0; flip < 2; flip++) {
+		if (vr_draw_texture(input, input_dim, fbo, output, fbo_dim, flip != 0) != GL_FRAMEBUFFER_COMPLETE_EXT) failures++;
+		std::vector<unsigned char> drawn = read_texture(check_fbo, output, fbo_dim);
+		if (!vr_blit_texture(read_fbo, input, GL_TEXTURE_RECTANGLE_ARB, input_dim, fbo, output, fbo_dim, flip != 0)) failures++;
+		std::vector<unsigned char> blitted = read_texture(check_fbo, output, fbo_dim);
+		bool same = drawn == blitted;
+		// flipped, the first row out is the last row in:
+		bool flipped = memcmp(&blitted[0], &pixels[flip ? (input_dim[1] - 1) * input_dim[0] * 4 : 0], input_dim[0] * 4) == 0;
+		printf("flipY %d: draw and blit %s, rows %s\n", flip, same ? "agree" : "DIFFER", flipped ? "ok" : "WRONG");
+		if (!same || !flipped) failures++;
+	}
+
+	// the blit must leave the state it touches as it found it:
+	glEnable(GL_SCISSOR_TEST);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, check_fbo);
+	vr_blit_texture(read_fbo, input, GL_TEXTURE_RECTANGLE_ARB, input_dim, fbo, output, fbo_dim, true);
+	GLint read_binding, draw_binding;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING_EXT, &read_binding);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING_EXT, &draw_binding);
+	if (!glIsEnabled(GL_SCISSOR_TEST) || read_binding != (GLint)check_fbo || draw_binding != (GLint)check_fbo) {
+		printf("blit changed the GL state\n");
+		failures++;
+	}
+	glDisable(GL_SCISSOR_TEST);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+	if (glGetError() != GL_NO_ERROR) {
+		printf("GL error\n");
+		failures++;
+	}
+
+	// the time to issue each copy (what the main thread pays), then with the GPU work as well:
+	double draw_ns = bench_ns([&] { vr_draw_texture(input, input_dim, fbo, output, fbo_dim, true); glFlush(); }, BENCH_CALLS);
+	double blit_ns = bench_ns([&] { vr_blit_texture(read_fbo, input, GL_TEXTURE_RECTANGLE_ARB, input_dim, fbo, output, fbo_dim, true); glFlush(); }, BENCH_CALLS);
+	glFinish();
+	bench_report("copy, issue", draw_ns, blit_ns, "copy");
+	draw_ns = bench_ns([&] { vr_draw_texture(input, input_dim, fbo, output, fbo_dim, true); glFinish(); }, BENCH_CALLS / 4);
+	blit_ns = bench_ns([&] { vr_blit_texture(read_fbo, input, GL_TEXTURE_RECTANGLE_ARB, input_dim, fbo, output, fbo_dim, true); glFinish(); }, BENCH_CALLS / 4);
+	bench_report("copy, finished", draw_ns, blit_ns, "copy");
+
+	printf("%s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
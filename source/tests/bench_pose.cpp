@@ -0,0 +1,59 @@
+// per-device cost of moving a tracked pose into world space:
+// before, through mat4 (translate * mat4_cast, view_mat * mat, then glm::quat_cast for the raw and world quats),
+// after, with Pose (al_math.h), which composes quat & vec3 directly
+
+#include <cmath>
+#include <vector>
+
+#include "al_math.h"
+#include "bench.h"
+
+#define BENCH_DEVICES (16)
+#define BENCH_FRAMES (20000)
+
+struct Tracked {
+	glm::quat quat;
+	glm::vec3 position;
+};
+
+int main() {
+	std::vector<Tracked> devices(BENCH_DEVICES);
+	for (int i = 0; i < BENCH_DEVICES; i++) {
+		glm::vec3 axis = glm::normalize(glm::vec3(sinf(i * 1.3f), cosf(i * 0.7f), 0.5f));
+		devices[i].quat = glm::angleAxis(0.3f * i, axis);
+		devices[i].position = glm::vec3(0.1f * i, 1.5f, -0.2f * i);
+	}
+	glm::quat view_quat = glm::normalize(glm::quat(0.9f, 0.1f, 0.4f, 0.1f));
+	glm::vec3 view_position(1.f, 0.f, -2.f);
+
+	// as output_tracked_pose() did:
+	double before = bench_ns([&] {
+		glm::mat4 view_mat = glm::translate(glm::mat4(1.0f), view_position) * mat4_cast(view_quat);
+		float sum = 0.f;
+		for (auto& d : devices) {
+			glm::mat4 mat = glm::translate(glm::mat4(1.0f), d.position) * mat4_cast(d.quat);
+			glm::vec3 p = glm::vec3(mat[3]);
+			glm::quat q = glm::quat_cast(mat);
+			glm::mat4 world_mat = view_mat * mat;
+			glm::vec3 p1 = glm::vec3(world_mat[3]);
+			glm::quat q1 = glm::quat_cast(world_mat);
+			sum += p.x + q.w + p1.x + q1.w;
+		}
+		bench_sink = sum;
+	}, BENCH_FRAMES);
+
+	// as it does now:
+	double after = bench_ns([&] {
+		Pose view_pose(view_quat, view_position);
+		float sum = 0.f;
+		for (auto& d : devices) {
+			Pose pose(d.quat, d.position);
+			Pose world = view_pose * pose;
+			sum += pose.position.x + pose.quat.w + world.position.x + world.quat.w;
+		}
+		bench_sink = sum;
+	}, BENCH_FRAMES);
+
+	bench_report("world pose", before / BENCH_DEVICES, after / BENCH_DEVICES, "device");
+	return 0;
+}
@@ -0,0 +1,121 @@
+// a writer thread publishing to pose channels (al_pose_channel.h) while a reader thread follows them,
+// as the vr object and an audio object's perform64 do, with the main thread switching the reader's channel:
+// every snapshot must be consistent, come from the channel currently followed, and never go back in time
+// also checks PoseChannel::named(), the @pose_channel lookup, against a stand-in for Max's symbol table
+
+#include <cstdio>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "al_pose_channel.h"
+
+#define TEST_WRITES (2000000)
+#define TEST_CHANNELS (2)
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static PoseChannel channels[TEST_CHANNELS];
+static std::atomic<PoseChannel *> followed { 0 };
+static std::atomic<bool> done { false };
+
+// every field is derived from the write number and the channel, so a torn read is detectable
+static void publish(int c, uint32_t n) {
+	float v = float(n % 65536);
+	channels[c].publish(glm::quat(v, v, v, v), glm::vec3(v, float(c), v), double(n));
+}
+
+static bool consistent(PoseSnapshot const& p, int c) {
+	float v = float(p.frame % 65536);
+	return p.quat.w == v && p.quat.x == v && p.quat.y == v && p.quat.z == v
+		&& p.position.x == v && p.position.y == float(c) && p.position.z == v;
+}
+
+// stand-ins for t_symbol, gensym & object_error
+struct Symbol {
+	const char * s_name;
+	void * s_thing;
+};
+
+static std::map<std::string, Symbol> symbols;
+static int errors = 0;
+
+static Symbol * test_gensym(const char * name) {
+	auto it = symbols.emplace(name, Symbol { 0, 0 }).first;
+	it->second.s_name = it->first.c_str();
+	return &it->second;
+}
+
+static void test_error(int * count, const char * fmt, ...) { (*count)++; }
+
+static void check_named() {
+	PoseChannel * head = PoseChannel::named(test_gensym, test_gensym("head"), &errors, test_error);
+	CHECK(head != 0);
+	CHECK(PoseChannel::named(test_gensym, test_gensym("head"), &errors, test_error) == head);
+	CHECK(PoseChannel::named(test_gensym, test_gensym("hand"), &errors, test_error) != head);
+	// no name means no channel, and isn't an error:
+	CHECK(PoseChannel::named(test_gensym, test_gensym(""), &errors, test_error) == 0);
+	CHECK(PoseChannel::named(test_gensym, (Symbol *)0, &errors, test_error) == 0);
+	CHECK(errors == 0);
+	// a slot holding something else is reported, and not used:
+	static int other = 0;
+	test_gensym("__vr_pose_channel_taken")->s_thing = &other;
+	CHECK(PoseChannel::named(test_gensym, test_gensym("taken"), &errors, test_error) == 0);
+	CHECK(errors == 1);
+}
+
+int main() {
+	check_named();
+
+	std::thread writer([] {
+		uint32_t n[TEST_CHANNELS] = { 0 };
+		for (int i = 0; i < TEST_WRITES; i++) {
+			int c = i % TEST_CHANNELS;
+			publish(c, ++n[c]);
+		}
+		done = true;
+	});
+
+	long reads = 0, valid = 0, switches = 0;
+	std::thread reader([&] {
+		PoseFollower follower;
+		uint32_t last_frame = 0;
+		const PoseChannel * last_channel = 0;
+		while (!done) {
+			const PoseChannel * current = followed.load();
+			bool ok = follower.update(current);
+			reads++;
+			if (current != last_channel) {
+				last_channel = current;
+				last_frame = 0;
+			}
+			if (!ok) continue;
+			valid++;
+			int c = int(current - channels);
+			CHECK(follower.channel == current);
+			CHECK(consistent(follower.pose, c));
+			CHECK(follower.pose.frame >= last_frame);
+			last_frame = follower.pose.frame;
+		}
+	});
+
+	// the main thread switches channels, including to none, as the pose_channel attribute does
+	for (int i = 0; !done; i++) {
+		int c = i % (TEST_CHANNELS + 1);
+		followed.store(c < TEST_CHANNELS ? &channels[c] : 0);
+		switches++;
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+
+	writer.join();
+	reader.join();
+
+	printf("%ld reads, %ld valid, %ld switches\n", reads, valid, switches);
+	CHECK(valid > 0);
+	CHECK(switches > 1);
+	printf("%s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
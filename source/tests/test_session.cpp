@@ -0,0 +1,131 @@
+// round trip of a session recording (vr_session.h) spanning several writer blocks:
+// every frame (rows, raw input & events) must read back as written, and seeking to any keyframe must land on it exactly
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include "vr_session.h"
+
+#define TEST_FRAMES (2000)
+#define TEST_DEVICES (16)
+#define TEST_COLUMNS (31)
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static const char * names[2] = { "head", "left_hand" };
+
+// deterministic content, changing every frame so that blocks fill quickly
+static void make_frame(int n, SessionFrame& frame) {
+	frame.time = n / 90.;
+	for (int e = 0; e < 2; e++) {
+		for (int i = 0; i < SESSION_EYE_FLOATS; i++) frame.eyes[e][i] = sinf(0.01f * n + e + i);
+	}
+	frame.numdevices = TEST_DEVICES;
+	for (int d = 0; d < TEST_DEVICES; d++) {
+		SessionDevice& dev = frame.devices[d];
+		dev.index = d;
+		dev.name = names[(d + n / 500) % 2];
+		for (int c = 0; c < SESSION_MAX_COLUMNS; c++) dev.row[c] = c < TEST_COLUMNS ? cosf(0.003f * n * (d + 1) + c) : 0.f;
+		// controllers only, and one that comes & goes, so that input is coded against a stale previous value:
+		dev.has_input = d % 3 != 0 && !(d == 1 && n % 5 == 0);
+		for (int w = 0; w < SESSION_INPUT_WORDS; w++) {
+			dev.input[w] = !dev.has_input ? 0
+				: w < SESSION_INPUT_AXES ? uint32_t((n / 10) * (w + 1) * 0x9e3779b9u)
+				: SessionCodec::float_bits(sinf(0.02f * n + d + w));
+		}
+	}
+	frame.numevents = n % 7 == 0 ? 1 : 0;
+	frame.events[0].type = n;
+	frame.events[0].device = n % TEST_DEVICES;
+	frame.events[0].age = 0.001f * (n % 11);
+	memset(frame.events[0].data, 0, SESSION_EVENT_DATA);
+	frame.events[0].data[0] = (unsigned char)n;
+	frame.events[0].data[SESSION_EVENT_DATA - 1] = (unsigned char)(n >> 8);
+}
+
+static bool same_frame(SessionFrame const& a, SessionFrame const& b) {
+	if (a.time != b.time || a.numdevices != b.numdevices || a.numevents != b.numevents) return false;
+	if (memcmp(a.eyes, b.eyes, sizeof(a.eyes)) != 0) return false;
+	for (int d = 0; d < a.numdevices; d++) {
+		if (a.devices[d].index != b.devices[d].index) return false;
+		if (strcmp(a.devices[d].name, b.devices[d].name) != 0) return false;
+		if (memcmp(a.devices[d].row, b.devices[d].row, TEST_COLUMNS * sizeof(float)) != 0) return false;
+		if (a.devices[d].has_input != b.devices[d].has_input) return false;
+		if (memcmp(a.devices[d].input, b.devices[d].input, sizeof(a.devices[d].input)) != 0) return false;
+	}
+	for (int i = 0; i < a.numevents; i++) {
+		if (a.events[i].type != b.events[i].type || a.events[i].device != b.events[i].device) return false;
+		if (a.events[i].age != b.events[i].age || memcmp(a.events[i].data, b.events[i].data, SESSION_EVENT_DATA) != 0) return false;
+	}
+	return true;
+}
+
+int main(int argc, char ** argv) {
+	const char * path = argc > 1 ? argv[1] : "test_session.vrsession";
+	static SessionFrame frame, expected;
+
+	SessionWriter writer;
+	CHECK(writer.open(path, TEST_COLUMNS));
+	for (int n = 0; n < TEST_FRAMES; n++) {
+		make_frame(n, frame);
+		// a full writer (both blocks busy) drops the frame; wait for it here, so that every frame is kept
+		while (!writer.write(frame)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK(writer.frames() == TEST_FRAMES);
+	writer.close();
+
+	SessionReader reader;
+	CHECK(reader.open(path));
+	CHECK(reader.columns() == TEST_COLUMNS);
+
+	// the recording must span several blocks for the test to mean anything:
+	FILE * f = fopen(path, "rb");
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fclose(f);
+	printf("%d frames, %ld bytes (%.1f blocks), %d keyframes\n", TEST_FRAMES, size, size / double(SESSION_BLOCK_SIZE), (int)reader.index().size());
+	CHECK(size > 2 * SESSION_BLOCK_SIZE);
+	CHECK(reader.index().size() == (TEST_FRAMES + SESSION_KEYFRAME_INTERVAL - 1) / SESSION_KEYFRAME_INTERVAL);
+
+	// sequential:
+	int n = 0;
+	while (reader.next(frame)) {
+		make_frame(n, expected);
+		if (!same_frame(frame, expected)) {
+			printf("frame %d differs\n", n);
+			failures++;
+			break;
+		}
+		n++;
+	}
+	CHECK(n == TEST_FRAMES);
+
+	// each keyframe, through the index:
+	for (auto& e : reader.index()) {
+		CHECK(e.frame % SESSION_KEYFRAME_INTERVAL == 0);
+		CHECK(reader.seek(e.time, frame));
+		make_frame(e.frame, expected);
+		if (!same_frame(frame, expected)) {
+			printf("seek to keyframe %u (offset %llu) differs\n", e.frame, (unsigned long long)e.offset);
+			failures++;
+		}
+		// and the frames that follow it:
+		for (int i = 1; i < SESSION_KEYFRAME_INTERVAL && e.frame + i < TEST_FRAMES; i++) {
+			CHECK(reader.next(frame));
+			make_frame(e.frame + i, expected);
+			if (!same_frame(frame, expected)) {
+				printf("frame %u after keyframe %u differs\n", e.frame + i, e.frame);
+				failures++;
+				break;
+			}
+		}
+	}
+	reader.close();
+	remove(path);
+
+	printf("%s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
@@ -195,10 +195,13 @@ struct VRContextObject {
 	t_atom_long simple_room_modeling = 0;
 	t_atom_long late_reverberation = 1;
 	t_atom_long randomize_reverberation = 1;
+	t_symbol * pose_channel_name;
 
 	// internal
 	VRContext * ctx;
 	float * ovrOutBuffer = 0;
+	std::atomic<PoseChannel *> pose_channel { 0 }; // if set, overrides @quat and @position (set by the main thread)
+	PoseFollower pose; // audio thread only
 
 	VRContextObject() {
 		// input signals:
@@ -211,6 +214,7 @@ struct VRContextObject {
 		outlet_new(&ob, "signal");
 
 		ctx = globalContext;
+		pose_channel_name = gensym("");
 		reverb_wet = 1.f;
 		reverb_range.x = 0.f;
 		reverb_range.y = 100.f;
@@ -264,7 +268,12 @@ struct VRContextObject {
 
 	void perform64(t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags) {
 		
-		updatePoseState();
+		// take the latest consistent head pose from a vr object, if there is one:
+		if (pose.update(pose_channel.load())) {
+			ctx->updatePoseState(head_radius, pose.pose.quat, pose.pose.position);
+		} else {
+			updatePoseState();
+		}
 		check(ovrAudio_SetListenerPoseStatef(ctx->audioContext, &ctx->poseState));
 		
 		// TODO: is it ok to do all these at control rate, rather than as attr setters?
@@ -391,6 +400,12 @@ struct VRContextObject {
 		}
 	};
 
+	static t_max_err pose_channel_set(VRContextObject * o, t_object *attr, long argc, t_atom *argv) {
+		o->pose_channel_name = argc ? atom_getsym(argv) : gensym("");
+		o->pose_channel.store(PoseChannel::named(gensym, o->pose_channel_name, (t_object *)o, object_error));
+		return MAX_ERR_NONE;
+	};
+
 	static void static_init() {
 		t_class * c = class_new("vr.context~", (method)create, (method)destroy, (long)sizeof(VRContextObject), 0L, A_GIMME, 0);
 
@@ -402,6 +417,9 @@ struct VRContextObject {
 		CLASS_ATTR_FLOAT_ARRAY(c, "position", 0, VRContextObject, position, 3);
 		CLASS_ATTR_ACCESSORS(c, "position", position_get, position_set);
 		CLASS_ATTR_FLOAT(c, "head_radius", 0, VRContextObject, head_radius);
+		// read the listener pose directly from a vr object with the same @pose_channel
+		CLASS_ATTR_SYM(c, "pose_channel", 0, VRContextObject, pose_channel_name);
+		CLASS_ATTR_ACCESSORS(c, "pose_channel", 0, pose_channel_set);
 		
 		CLASS_ATTR_FLOAT(c, "reverb_wet", 0, VRContextObject, reverb_wet);
 		CLASS_ATTR_FLOAT_ARRAY(c, "reverb_range", 0, VRContextObject, reverb_range, 2);
@@ -442,9 +460,12 @@ struct VRSourceObject {
 	t_atom_long wideband_hint = 1;
 	t_atom_long direct_delay = 0;
 	t_atom_long reflections = 0;
+	t_symbol * pose_channel_name;
 	
 	// internal
 	VRContext * ctx = 0;
+	std::atomic<PoseChannel *> pose_channel { 0 }; // if set, ear distances are computed from this pose (set by the main thread)
+	PoseFollower pose; // audio thread only
 	float * ovrInBuffer = 0;
 	float * ovrOutBuffer = 0;
 	float attenduatedGain = 1.f;
@@ -463,6 +484,7 @@ struct VRSourceObject {
 		outlet_new(&ob, "signal");
 		
 		ctx = globalContext;
+		pose_channel_name = gensym("");
 		
 		range.x = 0.f;
 		range.y = 100.f;
@@ -531,8 +553,14 @@ struct VRSourceObject {
 		configure();
 		
 		// compute ear distances:
-		float distance_left = glm::distance(ctx->ear_left, position);
-		float distance_right = glm::distance(ctx->ear_right, position);
+		glm::vec3 ear_left = ctx->ear_left, ear_right = ctx->ear_right;
+		if (pose.update(pose_channel.load())) {
+			glm::vec3 ear = quat_ux(pose.pose.quat) * ctx->head_radius;
+			ear_left = pose.pose.position - ear;
+			ear_right = pose.pose.position + ear;
+		}
+		float distance_left = glm::distance(ear_left, position);
+		float distance_right = glm::distance(ear_right, position);
 		
 		// convert to float32 :-(
 		{
@@ -632,6 +660,12 @@ struct VRSourceObject {
 			return MAX_ERR_NONE;
 		}
 	};
+
+	static t_max_err pose_channel_set(VRSourceObject * o, t_object *attr, long argc, t_atom *argv) {
+		o->pose_channel_name = argc ? atom_getsym(argv) : gensym("");
+		o->pose_channel.store(PoseChannel::named(gensym, o->pose_channel_name, (t_object *)o, object_error));
+		return MAX_ERR_NONE;
+	};
 	
 	static void static_init() {
 		t_class * c = class_new("vr.source~", (method)create, (method)destroy, (long)sizeof(VRSourceObject), 0L, A_GIMME, 0);
@@ -659,6 +693,10 @@ struct VRSourceObject {
 		CLASS_ATTR_LONG(c, "reflections", 0, VRSourceObject, reflections);
 		CLASS_ATTR_STYLE(c, "reflections", 0, "onoff");
 		
+		// compute ear distances from the pose of a vr object with the same @pose_channel
+		CLASS_ATTR_SYM(c, "pose_channel", 0, VRSourceObject, pose_channel_name);
+		CLASS_ATTR_ACCESSORS(c, "pose_channel", 0, pose_channel_set);
+		
 		class_dspinit(c);
 		class_register(CLASS_BOX, c);
 		maxclass = c;
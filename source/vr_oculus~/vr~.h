@@ -29,6 +29,7 @@ extern "C" {
 }
 
 #include "al_math.h"
+#include "al_pose_channel.h"
 
 #include "OVR_Audio.h"
 
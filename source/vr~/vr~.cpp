@@ -94,6 +94,11 @@ struct VR_Phonon_Global {
 	glm::vec3 position, position1;
 	glm::quat quat; // the listener's head orientation
 	float head_radius;
+	t_symbol * pose_channel_name = 0;
+	
+	// if set, the listener pose is read from here (published by a vr object) rather than @position/@quat
+	// set by the main thread, read by every vr.hrtf~ in perform64
+	std::atomic<PoseChannel *> pose_channel { 0 };
 	
 	
 	VR_Phonon_Global() {
@@ -325,6 +330,7 @@ struct VR_Phonon {
 	
 	VR_Phonon() {
 		outlet_msg = outlet_new(&ob, 0);
+		if (!global.pose_channel_name) global.pose_channel_name = gensym("");
 	}
 	
 	~VR_Phonon() {
@@ -338,7 +344,12 @@ struct VR_Phonon {
 	
 	void output_ear() {
 		t_atom a[3];
-		glm::vec3 ear = quat_ux(global.quat) * global.head_radius;
+		// the listener's orientation, as perform64 sees it:
+		glm::quat quat = global.quat;
+		PoseSnapshot snapshot;
+		PoseChannel * channel = global.pose_channel.load();
+		if (channel && channel->read(snapshot)) quat = snapshot.quat;
+		glm::vec3 ear = quat_ux(quat) * global.head_radius;
 		atom_setfloat(a + 0, ear.x);
 		atom_setfloat(a + 1, ear.y);
 		atom_setfloat(a + 2, ear.z);
@@ -433,6 +444,19 @@ struct VR_Phonon {
 		}
 	};
 	
+	static t_max_err pose_channel_get(VR_Phonon * o, t_object *attr, long *argc, t_atom **argv) {
+		char alloc;
+		atom_alloc_array(1, argc, argv, &alloc);
+		atom_setsym(*argv, global.pose_channel_name);
+		return 0;
+	};
+	static t_max_err pose_channel_set(VR_Phonon * o, t_object *attr, long argc, t_atom *argv) {
+		global.pose_channel_name = argc ? atom_getsym(argv) : gensym("");
+		global.pose_channel.store(PoseChannel::named(gensym, global.pose_channel_name, (t_object *)o, object_error));
+		o->output_ear();
+		return MAX_ERR_NONE;
+	};
+	
 	static void static_init() {
 		t_class * c = class_new("vr.phonon~", (method)create, (method)destroy, (long)sizeof(VR_Phonon), 0L, A_GIMME, 0);
 		
@@ -445,6 +469,10 @@ struct VR_Phonon {
 		CLASS_ATTR_FLOAT_ARRAY(c, "quat", 0, VR_Phonon, ob, 4);
 		CLASS_ATTR_ACCESSORS(c, "quat", quat_get, quat_set);
 		
+		// read the listener pose directly from a vr object with the same @pose_channel
+		CLASS_ATTR_SYM(c, "pose_channel", 0, VR_Phonon, ob);
+		CLASS_ATTR_ACCESSORS(c, "pose_channel", pose_channel_get, pose_channel_set);
+		
 		class_dspinit(c);
 		class_register(CLASS_BOX, c);
 		VR_Phonon_class = c;
@@ -472,6 +500,7 @@ struct VR_Phonon_hrtf {
 	IPLfloat32 * output_buffers2[2];
 	
 	int position_signal = 0;
+	PoseFollower pose; // latest listener pose from global.pose_channel (audio thread only)
 	
 	
 	VR_Phonon_hrtf() {
@@ -575,22 +604,30 @@ struct VR_Phonon_hrtf {
 			position.z = *(ins[3]);
 		}
 	
+		// listener pose: a consistent snapshot from a vr object if available, else the vr.phonon~ attrs
+		glm::quat listener_quat = global.quat;
+		glm::vec3 listener_position = global.position;
+		if (pose.update(global.pose_channel.load())) {
+			listener_quat = pose.pose.quat;
+			listener_position = pose.pose.position;
+		}
+		
 		glm::vec3 dirn_l, dirn_r;
 		float distance_l, distance_r;
 		if (interaural) {
-			glm::vec3 ear = quat_ux(global.quat) * global.head_radius;
-			glm::vec3 rel_l = position - (global.position - ear);
-			glm::vec3 rel_r = position - (global.position + ear);
-			glm::vec3 dir_l = quat_unrotate(global.quat, rel_l);
-			glm::vec3 dir_r = quat_unrotate(global.quat, rel_r);
+			glm::vec3 ear = quat_ux(listener_quat) * global.head_radius;
+			glm::vec3 rel_l = position - (listener_position - ear);
+			glm::vec3 rel_r = position - (listener_position + ear);
+			glm::vec3 dir_l = quat_unrotate(listener_quat, rel_l);
+			glm::vec3 dir_r = quat_unrotate(listener_quat, rel_r);
 			distance_l = glm::length(rel_l);
 			distance_r = glm::length(rel_r);
 			// TODO: handle cases where distance is close to zero (where there's no direction in particular)
 			dirn_l = glm::normalize(dir_l);
 			dirn_r = glm::normalize(dir_r);
 		} else {
-			glm::vec3 rel_l = position - (global.position);
-			glm::vec3 dir_l = quat_unrotate(global.quat, rel_l);
+			glm::vec3 rel_l = position - (listener_position);
+			glm::vec3 dir_l = quat_unrotate(listener_quat, rel_l);
 			distance_l = glm::length(rel_l);
 			distance_r = distance_l;
 			// TODO: handle cases where distance is close to zero (where there's no direction in particular)
@@ -29,6 +29,7 @@ extern "C" {
 }
 
 #include "al_math.h"
+#include "al_pose_channel.h"
 
 #include "steamaudio_api/include/phonon.h"
 